@@ -0,0 +1,75 @@
+#include "AssetWatcher.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+AssetWatcher::AssetWatcher(std::string const &directory) {
+	#if defined(__linux__)
+	fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (fd < 0) {
+		throw std::runtime_error("Failed to create inotify instance to watch '" + directory + "'.");
+	}
+	//(IN_MOVED_TO catches tools that write a temporary file and rename it over the old one)
+	if (inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+		stop();
+		throw std::runtime_error("Failed to watch directory '" + directory + "'.");
+	}
+	#else
+	(void)directory;
+	#endif
+}
+
+AssetWatcher::~AssetWatcher() {
+	stop();
+}
+
+AssetWatcher::AssetWatcher(AssetWatcher &&other) {
+	*this = std::move(other);
+}
+
+AssetWatcher &AssetWatcher::operator=(AssetWatcher &&other) {
+	if (this == &other) return *this;
+	stop();
+	std::swap(fd, other.fd);
+	return *this;
+}
+
+std::vector< std::string > AssetWatcher::poll() {
+	std::vector< std::string > changed;
+	#if defined(__linux__)
+	if (fd < 0) return changed;
+
+	alignas(inotify_event) char buffer[4096];
+	while (true) {
+		//non-blocking, so this fails with EAGAIN once there are no more events:
+		ssize_t got = read(fd, buffer, sizeof(buffer));
+		if (got <= 0) break;
+		for (char const *at = buffer; at < buffer + got; ) {
+			inotify_event const &event = *reinterpret_cast< inotify_event const * >(at);
+			if (event.len > 0) {
+				std::string name(event.name); //(name is padded with '\0's to event.len)
+				if (std::find(changed.begin(), changed.end(), name) == changed.end()) {
+					changed.emplace_back(std::move(name));
+				}
+			}
+			at += sizeof(inotify_event) + event.len;
+		}
+	}
+	#endif
+	return changed;
+}
+
+void AssetWatcher::stop() {
+	#if defined(__linux__)
+	if (fd >= 0) {
+		close(fd); //(also removes the watch)
+		fd = -1;
+	}
+	#endif
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+/*
+ * An AssetWatcher reports files in a directory that have been rewritten, so assets can be hot reloaded:
+ *
+ * AssetWatcher watcher(data_path("assets"));
+ * //...once per frame:
+ * for (std::string const &name : watcher.poll()) {
+ *     if (name == "tiles.bin") reload_tiles();
+ * }
+ *
+ * Files count as changed once whatever wrote them closes them (or moves them into place),
+ * so poll() doesn't see half-written files.
+ *
+ * Uses inotify on Linux; on other platforms, an AssetWatcher never reports any changes.
+ */
+
+#include <string>
+#include <vector>
+
+struct AssetWatcher {
+	AssetWatcher() = default;
+	//start watching 'directory' (throws on failure):
+	explicit AssetWatcher(std::string const &directory);
+	~AssetWatcher();
+
+	//a watch has exactly one owner:
+	AssetWatcher(AssetWatcher const &) = delete;
+	AssetWatcher &operator=(AssetWatcher const &) = delete;
+	AssetWatcher(AssetWatcher &&);
+	AssetWatcher &operator=(AssetWatcher &&);
+
+	//names (relative to the directory) of files changed since the last call, without duplicates; never blocks:
+	std::vector< std::string > poll();
+
+private:
+	void stop();
+
+	int fd = -1; //inotify instance (Linux only)
+};
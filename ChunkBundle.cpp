@@ -0,0 +1,75 @@
+#include "ChunkBundle.hpp"
+
+#include <stdexcept>
+
+ChunkBundle::ChunkBundle(std::string const &filename) : file(filename) {
+	size_t offset = 0;
+	ChunkView< Entry > entries = view_chunk< Entry >(file, &offset, "ctoc");
+
+	toc.reserve(entries.size());
+	for (Entry const &e : entries) {
+		if (e.offset % Alignment != 0) {
+			throw std::runtime_error("Chunk in '" + filename + "' is not aligned.");
+		}
+		if (e.offset < offset || e.offset > file.size() || file.size() - e.offset < e.size) {
+			throw std::runtime_error("Chunk in '" + filename + "' extends outside of file.");
+		}
+		if (e.codec() >= MaxChunkCodec) {
+			throw std::runtime_error("Chunk in '" + filename + "' has unknown codec.");
+		}
+		if (!toc.emplace(e.fourcc, e).second) {
+			throw std::runtime_error("Duplicate chunk in '" + filename + "'.");
+		}
+	}
+}
+
+ChunkBundle::Entry const &ChunkBundle::entry(uint32_t code) const {
+	auto f = toc.find(code);
+	if (f == toc.end()) {
+		throw std::runtime_error("Chunk '" + std::string(reinterpret_cast< char const * >(&code), 4) + "' not found in bundle.");
+	}
+	return f->second;
+}
+
+void ChunkBundle::read(uint32_t code, uint8_t *to, size_t to_size) const {
+	Entry const &e = entry(code);
+	if (to_size != e.raw_size) {
+		throw std::runtime_error("Chunk read into buffer of wrong size.");
+	}
+	decompress_chunk(e.codec(), file.data() + e.offset, e.size, to, to_size);
+}
+
+void ChunkBundleWriter::write(std::ostream *to_) const {
+	assert(to_);
+	auto &to = *to_;
+
+	auto padded = [](size_t size) {
+		return (size + ChunkBundle::Alignment - 1) / ChunkBundle::Alignment * ChunkBundle::Alignment;
+	};
+
+	//lay out the table of contents:
+	std::vector< ChunkBundle::Entry > entries;
+	entries.reserve(chunks.size());
+	size_t offset = padded(8 + chunks.size() * sizeof(ChunkBundle::Entry));
+	for (auto const &chunk : chunks) {
+		ChunkBundle::Entry e;
+		e.fourcc = chunk.fourcc;
+		e.offset = uint32_t(offset);
+		e.size = uint32_t(chunk.data.size());
+		e.flags = chunk.codec;
+		e.raw_size = chunk.raw_size;
+		entries.emplace_back(e);
+		offset = padded(offset + chunk.data.size());
+	}
+	write_chunk("ctoc", entries, &to);
+
+	//write chunk data at the offsets promised above:
+	static const char zeros[ChunkBundle::Alignment] = { };
+	size_t written = 8 + entries.size() * sizeof(ChunkBundle::Entry);
+	for (size_t i = 0; i < chunks.size(); ++i) {
+		to.write(zeros, entries[i].offset - written);
+		to.write(reinterpret_cast< char const * >(chunks[i].data.data()), chunks[i].data.size());
+		written = entries[i].offset + chunks[i].data.size();
+	}
+	to.write(zeros, padded(written) - written);
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+/*
+ * A ChunkBundle is a file holding several chunks of data, indexed by a leading table of contents.
+ *
+ * Unlike a sequence of read_chunk() calls, chunks can be fetched in any order (or not at all) by FourCC:
+ *
+ * ChunkBundle level(data_path("assets/level-layout.bin"));
+ * ChunkView< char > layout = level.view< char >(fourcc("Q_LL"));
+ *
+ * The bundle is memory-mapped and never modified after construction,
+ *  so chunks can be fetched from several threads at once (e.g., to decode them in parallel).
+ *
+ * Chunks may be stored compressed (see chunk_codecs.hpp); these can't be viewed in place,
+ *  but read() decompresses them straight into the destination buffer:
+ *
+ * std::vector< uint8_t > tiles;
+ * bundle.read(fourcc("TILE"), &tiles);
+ *
+ * File format:
+ * |ct|oc|sz|sz| Entry * (sz/sizeof(Entry)) <-- table of contents, written with write_chunk
+ * ...padding to 16 bytes...
+ * |data........| <-- chunk data; each chunk starts at a multiple of 16 bytes from the start of the file
+ * ...padding to 16 bytes...
+ * |data........|
+ * ...
+ */
+
+#include "MappedFile.hpp"
+#include "read_write_chunk.hpp"
+#include "chunk_codecs.hpp"
+
+#include <unordered_map>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+//compile-time four-character code, packed so its (native endian) bytes match the characters:
+constexpr uint32_t fourcc(char const (&code)[5]) {
+	return uint32_t(uint8_t(code[0]))
+	     | uint32_t(uint8_t(code[1])) << 8
+	     | uint32_t(uint8_t(code[2])) << 16
+	     | uint32_t(uint8_t(code[3])) << 24;
+}
+
+struct ChunkBundle {
+	//table of contents entry:
+	struct Entry {
+		uint32_t fourcc = 0; //chunk name
+		uint32_t offset = 0; //byte offset of chunk data from the start of the file
+		uint32_t size = 0; //size of (stored, possibly compressed) chunk data in bytes
+		uint32_t flags = 0; //bits 0-7: ChunkCodec; other bits reserved, written as zero
+		uint32_t raw_size = 0; //size of chunk data after decompression
+
+		ChunkCodec codec() const { return ChunkCodec(flags & 0xff); }
+	};
+	static_assert(sizeof(Entry) == 20, "Entry is packed");
+
+	//chunk data is aligned to this many bytes from the start of the (page-aligned) mapping:
+	static constexpr uint32_t Alignment = 16;
+
+	ChunkBundle() = default;
+	//map 'filename' and read its table of contents (throws on failure):
+	explicit ChunkBundle(std::string const &filename);
+
+	bool has(uint32_t code) const { return toc.count(code) != 0; }
+	//throws if there is no such chunk:
+	Entry const &entry(uint32_t code) const;
+
+	//view chunk data in place (throws if missing, badly sized, or compressed):
+	template< typename T >
+	ChunkView< T > view(uint32_t code) const;
+
+	//decompress (or copy) chunk data into 'to', which must hold exactly entry(code).raw_size bytes:
+	void read(uint32_t code, uint8_t *to, size_t to_size) const;
+
+	//resize 'to' to fit and read chunk data into it (throws if missing or badly sized):
+	template< typename T >
+	void read(uint32_t code, std::vector< T > *to) const;
+
+	MappedFile file;
+	std::unordered_map< uint32_t, Entry > toc;
+};
+
+//Collects chunks and writes them out in ChunkBundle format:
+struct ChunkBundleWriter {
+	//data is stored with 'codec' unless that wouldn't make it smaller:
+	template< typename T >
+	void add(uint32_t code, std::vector< T > const &data, ChunkCodec codec = ChunkCodecNone);
+
+	void write(std::ostream *to) const;
+
+	struct Pending {
+		uint32_t fourcc;
+		ChunkCodec codec;
+		uint32_t raw_size;
+		std::vector< uint8_t > data; //(compressed with codec)
+	};
+	std::vector< Pending > chunks;
+};
+
+//-------------------------------------------------------------------
+
+template< typename T >
+ChunkView< T > ChunkBundle::view(uint32_t code) const {
+	static_assert(std::is_trivially_copyable< T >::value, "chunk data is used as raw bytes");
+	static_assert(Alignment % alignof(T) == 0, "bundle alignment suffices for T");
+	Entry const &e = entry(code);
+	if (e.codec() != ChunkCodecNone) {
+		throw std::runtime_error("Compressed chunk can't be viewed in place.");
+	}
+	if (e.size % sizeof(T) != 0) {
+		throw std::runtime_error("Size of chunk not divisible by element size");
+	}
+	ChunkView< T > ret;
+	ret.data_ = reinterpret_cast< T const * >(file.data() + e.offset);
+	ret.size_ = e.size / sizeof(T);
+	return ret;
+}
+
+template< typename T >
+void ChunkBundle::read(uint32_t code, std::vector< T > *to_) const {
+	static_assert(std::is_trivially_copyable< T >::value, "chunk data is used as raw bytes");
+	assert(to_);
+	auto &to = *to_;
+	Entry const &e = entry(code);
+	if (e.raw_size % sizeof(T) != 0) {
+		throw std::runtime_error("Size of chunk not divisible by element size");
+	}
+	to.resize(e.raw_size / sizeof(T));
+	read(code, reinterpret_cast< uint8_t * >(to.data()), e.raw_size);
+}
+
+template< typename T >
+void ChunkBundleWriter::add(uint32_t code, std::vector< T > const &data, ChunkCodec codec) {
+	static_assert(std::is_trivially_copyable< T >::value, "chunk data is used as raw bytes");
+	for (auto const &chunk : chunks) {
+		if (chunk.fourcc == code) throw std::runtime_error("Duplicate chunk in bundle.");
+	}
+	uint8_t const *bytes = reinterpret_cast< uint8_t const * >(data.data());
+	size_t size = data.size() * sizeof(T);
+
+	Pending chunk;
+	chunk.fourcc = code;
+	chunk.codec = codec;
+	chunk.raw_size = uint32_t(size);
+	chunk.data = compress_chunk(codec, bytes, size);
+	if (codec != ChunkCodecNone && chunk.data.size() >= size) {
+		chunk.codec = ChunkCodecNone;
+		chunk.data.assign(bytes, bytes + size);
+	}
+	chunks.emplace_back(std::move(chunk));
+}
@@ -0,0 +1,63 @@
+#include "InputRecording.hpp"
+
+#include "read_write_chunk.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <fstream>
+#include <stdexcept>
+
+void InputRecording::record(SDL_Event const &evt) {
+	if (evt.type != SDL_KEYDOWN && evt.type != SDL_KEYUP) return;
+	Key key;
+	key.frame = uint32_t(elapsed.size());
+	key.key = int32_t(evt.key.keysym.sym);
+	key.state = (evt.type == SDL_KEYDOWN ? SDL_PRESSED : SDL_RELEASED);
+	keys.emplace_back(key);
+}
+
+void InputRecording::events(uint32_t frame, std::vector< SDL_Event > *events_) const {
+	assert(events_);
+	auto &events = *events_;
+	auto begin = std::lower_bound(keys.begin(), keys.end(), frame, [](Key const &key, uint32_t frame) {
+		return key.frame < frame;
+	});
+	for (auto k = begin; k != keys.end() && k->frame == frame; ++k) {
+		SDL_Event evt{};
+		evt.type = (k->state == SDL_PRESSED ? SDL_KEYDOWN : SDL_KEYUP);
+		evt.key.type = evt.type;
+		evt.key.state = k->state;
+		evt.key.keysym.sym = SDL_Keycode(k->key);
+		events.emplace_back(evt);
+	}
+}
+
+void InputRecording::save(std::string const &filename) const {
+	std::ofstream out(filename, std::ios::binary);
+	write_chunk("frm0", elapsed, &out);
+	write_chunk("key0", keys, &out);
+	write_chunk("sum0", std::vector< uint64_t >{ checksum }, &out);
+	if (!out) {
+		throw std::runtime_error("Failed to write input recording to '" + filename + "'.");
+	}
+}
+
+InputRecording InputRecording::load(std::string const &filename) {
+	std::ifstream in(filename, std::ios::binary);
+	if (!in) {
+		throw std::runtime_error("Failed to open input recording '" + filename + "'.");
+	}
+	InputRecording recording;
+	read_chunk(in, "frm0", &recording.elapsed);
+	read_chunk(in, "key0", &recording.keys);
+	std::vector< uint64_t > checksum;
+	read_chunk(in, "sum0", &checksum);
+	if (checksum.size() != 1) {
+		throw std::runtime_error("Input recording '" + filename + "' has a bad checksum chunk.");
+	}
+	recording.checksum = checksum[0];
+	if (!std::is_sorted(recording.keys.begin(), recording.keys.end(), [](Key const &a, Key const &b) { return a.frame < b.frame; })) {
+		throw std::runtime_error("Input recording '" + filename + "' has key events out of order.");
+	}
+	return recording;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+/*
+ * An InputRecording holds the keyboard input and frame times of a play session,
+ * so the session can be replayed exactly (e.g., as a repeatable benchmark; see main.cpp's --record and --replay):
+ *
+ * //while playing:
+ * recording.record(evt); //for each event passed to the mode (that changes the game state -- see main.cpp's Session::replayable)
+ * recording.elapsed.emplace_back(elapsed); //for each frame
+ * //...at the end:
+ * recording.save("session.rec");
+ *
+ * //later:
+ * InputRecording replay = InputRecording::load("session.rec");
+ * replay.events(frame, &events); //events to pass to the mode during 'frame'
+ *
+ * Since the mode only ever sees the recorded events and (through the fixed-step loop) the recorded frame times,
+ *  it is updated exactly as it was while recording.
+ *
+ * File format (chunks written with write_chunk):
+ *  "frm0": one float per frame -- seconds elapsed since the previous frame
+ *  "key0": one Key per key event, in the order they reached the mode
+ *  "sum0": one uint64_t -- checksum of the game state at the end of the session, to check replays against
+ */
+
+#include <SDL.h>
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+struct InputRecording {
+	struct Key {
+		uint32_t frame; //index (in 'elapsed') of the frame during which the event arrived
+		int32_t key; //SDL_Keycode
+		uint8_t state; //SDL_PRESSED or SDL_RELEASED
+		uint8_t padding[3] = {0, 0, 0};
+	};
+	static_assert(sizeof(Key) == 12, "Key is packed");
+
+	std::vector< float > elapsed;
+	std::vector< Key > keys; //(in order of frame)
+	uint64_t checksum = 0;
+
+	//record a key event during the frame that's in progress (i.e., frame elapsed.size()); other events are ignored:
+	void record(SDL_Event const &evt);
+
+	//key events that arrived during 'frame', rebuilt as SDL_Events, are appended to 'events':
+	void events(uint32_t frame, std::vector< SDL_Event > *events) const;
+
+	//write to (or read from) a file; throws on failure:
+	void save(std::string const &filename) const;
+	static InputRecording load(std::string const &filename);
+};
@@ -1,32 +1,282 @@
 #include "Load.hpp"
+#include "startup_timing.hpp"
 
+#include <algorithm>
 #include <array>
-#include <list>
 #include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace {
-	std::array< std::list< std::function< void() > >, MaxLoadTag > &get_load_lists() {
-		static std::array< std::list< std::function< void() > >, MaxLoadTag > load_lists;
-		return load_lists;
+	struct LoadFunction {
+		LoadTag tag;
+		std::function< void() > fn;
+		LoadOptions options;
+		void const *key;
+		std::string label; //"file:line" of whoever added it
+	};
+
+	std::vector< LoadFunction > &get_load_functions() {
+		static std::vector< LoadFunction > load_functions;
+		return load_functions;
+	}
+
+	//just the file name is plenty to find the Load<> by:
+	std::string label_for(char const *file, uint32_t line) {
+		std::string label = file;
+		return label.substr(label.find_last_of("/\\") + 1) + ":" + std::to_string(line);
 	}
+
+	//the thread that runs LoadGLThread functions (set once, by start_load_functions, before any other threads start):
+	std::thread::id gl_thread;
 }
 
-void add_load_function(LoadTag tag, std::function< void() > const &fn) {
-	auto &load_lists = get_load_lists();
-	assert(tag < load_lists.size());
-	load_lists[tag].emplace_back(fn);
+void add_load_function(LoadTag tag, std::function< void() > const &fn, LoadOptions const &options, void const *key, char const *file, uint32_t line) {
+	assert(tag < MaxLoadTag);
+	get_load_functions().emplace_back(LoadFunction{tag, fn, options, key, label_for(file, line)});
 }
 
-void call_load_functions() {
+void call_lazy_load_function(LoadThread thread, std::function< void() > const &fn, char const *file, uint32_t line) {
+	std::string label = label_for(file, line);
+	if (thread == LoadGLThread && std::this_thread::get_id() != gl_thread) {
+		throw std::runtime_error("LazyLoad at " + label + " needs the GL thread, but was used from another thread (or without OpenGL).");
+	}
+	StartupPhase timing("LazyLoad " + label);
+	fn();
+}
+
+struct LoadProgress::Schedule {
+	std::vector< LoadFunction > functions;
+	std::unordered_map< void const *, size_t > function_for_key;
+
+	std::vector< uint32_t > waiting_on; //unfinished dependencies of each function
+	std::vector< std::vector< size_t > > dependents; //functions waiting on each function
+	std::array< size_t, MaxLoadTag > unfinished_in_tag = {}; //(tags run in order, so each is also a barrier)
+
+	//scheduling state, shared with worker threads:
+	mutable std::mutex mutex;
+	std::condition_variable changed; //signalled when work becomes ready or finishes
+	std::deque< size_t > ready_gl, ready_any; //functions whose dependencies are done, by the thread they need
+	uint32_t open_tag = 0; //functions in tags up to this one may run
+	size_t running = 0;
+	size_t finished = 0;
+	std::vector< bool > is_finished;
+	std::exception_ptr error; //first exception thrown by a loading function (stops launching any more)
+	bool stopping = false; //LoadProgress is being destroyed
+
+	std::vector< std::thread > workers; //run LoadAnyThread functions
+
+	//(all of these expect mutex to be held)
+	void make_ready(size_t i) {
+		(functions[i].options.thread == LoadGLThread ? ready_gl : ready_any).emplace_back(i);
+	}
+	void open_tags() {
+		//open the next tag whenever everything in the current one has finished:
+		while (open_tag < MaxLoadTag && unfinished_in_tag[open_tag] == 0) {
+			open_tag += 1;
+			if (open_tag == MaxLoadTag) break;
+			for (size_t i = 0; i < functions.size(); ++i) {
+				if (functions[i].tag == open_tag && waiting_on[i] == 0) make_ready(i);
+			}
+		}
+	}
+	void finish(size_t i) {
+		running -= 1;
+		finished += 1;
+		is_finished[i] = true;
+		unfinished_in_tag[functions[i].tag] -= 1;
+		for (size_t d : dependents[i]) {
+			waiting_on[d] -= 1;
+			if (waiting_on[d] == 0 && functions[d].tag <= open_tag) make_ready(d);
+		}
+		open_tags();
+	}
+	//run function i (it is released while the function runs):
+	void run(std::unique_lock< std::mutex > &lock, size_t i) {
+		running += 1;
+		lock.unlock();
+		std::exception_ptr thrown;
+		try {
+			StartupPhase timing("Load " + functions[i].label);
+			functions[i].fn();
+		} catch (...) {
+			thrown = std::current_exception();
+		}
+		lock.lock();
+		if (thrown && !error) error = thrown;
+		finish(i);
+		changed.notify_all();
+	}
+	//nothing running and nothing ready, but not done:
+	bool stuck() const {
+		return running == 0 && ready_gl.empty() && ready_any.empty() && finished < functions.size();
+	}
+
+	void worker() {
+		std::unique_lock< std::mutex > lock(mutex);
+		while (true) {
+			changed.wait(lock, [&]() {
+				return !ready_any.empty() || finished == functions.size() || error || stopping || stuck();
+			});
+			if (ready_any.empty() || error || stopping) break; //done (or stuck or failed; update() reports that)
+			size_t i = ready_any.front();
+			ready_any.pop_front();
+			run(lock, i);
+		}
+	}
+};
+
+static std::shared_ptr< LoadProgress > start_load_functions(bool with_gl) {
 	static bool has_been_called = false;
-	assert(!has_been_called && "call_load_functions should only be called *once*");
+	assert(!has_been_called && "start_load_functions (or call_load_functions) should only be called *once*");
 	has_been_called = true;
 
-	auto &load_lists = get_load_lists();
-	for (auto &fn_list : load_lists) {
-		while (!fn_list.empty()) {
-			(*fn_list.begin())(); //call first function in the list
-			fn_list.pop_front(); //remove from list
+	auto progress = std::make_shared< LoadProgress >();
+	progress->schedule.reset(new LoadProgress::Schedule);
+	LoadProgress::Schedule &s = *progress->schedule;
+
+	if (with_gl) gl_thread = std::this_thread::get_id();
+
+	s.functions = std::move(get_load_functions());
+	get_load_functions().clear();
+
+	if (!with_gl) {
+		//drop functions that need the GL thread, and (repeatedly) anything that depends on a dropped function:
+		std::unordered_set< void const * > skipped;
+		auto skip = [&skipped](LoadFunction const &f) {
+			bool needs_skipped = f.options.thread == LoadGLThread || std::any_of(f.options.depends.begin(), f.options.depends.end(),
+				[&skipped](void const *key) { return skipped.count(key) != 0; });
+			if (needs_skipped && f.key) skipped.emplace(f.key);
+			return needs_skipped;
+		};
+		for (size_t before = s.functions.size() + 1; before != s.functions.size(); ) {
+			before = s.functions.size();
+			s.functions.erase(std::remove_if(s.functions.begin(), s.functions.end(), skip), s.functions.end());
+		}
+	}
+
+	//turn the functions into a dependency graph:
+	// (dependencies reference functions by key, so keys may be added in any order -- e.g., from different translation units)
+	std::vector< LoadFunction > const &functions = s.functions;
+
+	for (size_t i = 0; i < functions.size(); ++i) {
+		if (functions[i].key) s.function_for_key.emplace(functions[i].key, i);
+	}
+
+	s.waiting_on.assign(functions.size(), 0);
+	s.dependents.resize(functions.size());
+	s.is_finished.assign(functions.size(), false);
+	for (size_t i = 0; i < functions.size(); ++i) {
+		s.unfinished_in_tag[functions[i].tag] += 1;
+		for (void const *key : functions[i].options.depends) {
+			auto f = s.function_for_key.find(key);
+			if (f == s.function_for_key.end()) {
+				throw std::runtime_error("Loading function depends on something that was never added.");
+			}
+			s.waiting_on[i] += 1;
+			s.dependents[f->second].emplace_back(i);
 		}
 	}
+
+	{ //functions with no dependencies in the first tag(s) are ready right away:
+		std::unique_lock< std::mutex > lock(s.mutex);
+		for (size_t i = 0; i < functions.size(); ++i) {
+			if (functions[i].tag == 0 && s.waiting_on[i] == 0) s.make_ready(i);
+		}
+		s.open_tags();
+	}
+
+	//worker threads run LoadAnyThread functions:
+	size_t any_thread_functions = std::count_if(functions.begin(), functions.end(), [](LoadFunction const &f) {
+		return f.options.thread == LoadAnyThread;
+	});
+	uint32_t worker_count = uint32_t(std::min< size_t >(any_thread_functions, std::max(1u, std::thread::hardware_concurrency())));
+	for (uint32_t w = 0; w < worker_count; ++w) {
+		s.workers.emplace_back(&LoadProgress::Schedule::worker, &s);
+	}
+
+	return progress;
+}
+
+std::shared_ptr< LoadProgress > start_load_functions() {
+	return start_load_functions(true);
+}
+
+void LoadProgress::update(float budget) {
+	Schedule &s = *schedule;
+	auto end = std::chrono::steady_clock::now() + std::chrono::duration< float >(std::max(0.0f, budget));
+
+	std::unique_lock< std::mutex > lock(s.mutex);
+	for (bool first = true; true; first = false) {
+		if (s.error) {
+			//let running functions finish before reporting the error:
+			if (s.running == 0) std::rethrow_exception(s.error);
+			if (budget >= 0.0f) return;
+			s.changed.wait(lock);
+			continue;
+		}
+		if (s.finished == s.functions.size()) return;
+		if (s.stuck()) {
+			throw std::runtime_error("Loading functions have circular dependencies (or depend on functions with later tags).");
+		}
+		if (!s.ready_gl.empty()) {
+			//(always run at least one function, so even tiny budgets make progress)
+			if (!first && budget >= 0.0f && std::chrono::steady_clock::now() >= end) return;
+			size_t i = s.ready_gl.front();
+			s.ready_gl.pop_front();
+			s.run(lock, i);
+			continue;
+		}
+		//only worker threads have work to do:
+		if (budget >= 0.0f) return;
+		s.changed.wait(lock);
+	}
+}
+
+size_t LoadProgress::total() const {
+	return schedule->functions.size();
+}
+
+size_t LoadProgress::finished() const {
+	std::lock_guard< std::mutex > lock(schedule->mutex);
+	return schedule->finished;
+}
+
+bool LoadProgress::loaded(void const *key) const {
+	auto f = schedule->function_for_key.find(key);
+	if (f == schedule->function_for_key.end()) return false;
+	std::lock_guard< std::mutex > lock(schedule->mutex);
+	return schedule->is_finished[f->second];
+}
+
+bool LoadProgress::loaded(LoadTag tag) const {
+	std::lock_guard< std::mutex > lock(schedule->mutex);
+	return schedule->open_tag > tag;
+}
+
+LoadProgress::~LoadProgress() {
+	if (!schedule) return;
+	{
+		std::lock_guard< std::mutex > lock(schedule->mutex);
+		schedule->stopping = true;
+	}
+	schedule->changed.notify_all();
+	for (auto &worker : schedule->workers) {
+		worker.join();
+	}
+}
+
+void call_load_functions() {
+	//(same as loading asynchronously, and then waiting for everything to finish)
+	start_load_functions()->update(-1.0f);
+}
+
+void call_load_functions_without_gl() {
+	start_load_functions(false)->update(-1.0f);
 }
@@ -20,11 +20,24 @@
  * These functions are grouped by 'tags', which allow some sequencing of calls.
  * (particularly, this is useful for loading large data blobs [e.g. Meshes] before looking up individual elements within them.)
  *
+ * Finer-grained sequencing is possible by listing the Load<>s that a function depends on;
+ * functions that don't need the OpenGL context can then run on worker threads alongside everything else:
+ *
+ * Load< Level > level(LoadTagDefault, LoadOptions{ LoadAnyThread }, [](){ return new Level(data_path("level.bin")); });
+ * Load< LevelMesh > level_mesh(LoadTagDefault, LoadOptions{ LoadGLThread, { &level } }, [](){ return new LevelMesh(*level); });
+ *
+ * (so startup takes about as long as the longest chain of dependencies, not the sum of every loading function)
+ *
  */
 
 #include <functional>
 #include <stdexcept>
 #include <cstdint>
+#include <vector>
+#include <atomic>
+#include <future>
+#include <memory>
+#include <mutex>
 
 enum LoadTag : uint32_t {
 	LoadTagEarly,
@@ -33,15 +46,76 @@ enum LoadTag : uint32_t {
 	MaxLoadTag //<-- just used to track # of load tags
 };
 
+enum LoadThread : uint32_t {
+	LoadGLThread, //must run on the thread that owns the OpenGL context (the thread calling call_load_functions or LoadProgress::update)
+	LoadAnyThread, //only does CPU work, so may run on a worker thread
+};
+
+struct LoadOptions {
+	LoadThread thread = LoadGLThread;
+	//functions that must finish first, given by key (the address of their Load<>, or the key passed to add_load_function):
+	// (every function also waits for all functions with earlier tags)
+	std::vector< void const * > depends = {};
+};
+
 //Add a function to an internal list of loading functions:
+// key (optional) is what other loading functions can list in LoadOptions::depends to wait for this one
+// file and line label the function in the startup timing report (see startup_timing.hpp); they default to the caller's location
 // (only call *before* "call_load_functions()")
-void add_load_function(LoadTag tag, std::function< void() > const &fn);
+void add_load_function(LoadTag tag, std::function< void() > const &fn, LoadOptions const &options = LoadOptions(), void const *key = nullptr,
+	char const *file = __builtin_FILE(), uint32_t line = __builtin_LINE());
 
 //Call all loading functions:
-// (loading functions may throw exceptions if they fail.)
-// (only call *once*)
+// LoadGLThread functions are run on the calling thread, LoadAnyThread functions on a pool of worker threads,
+//  each as soon as the functions it depends on are done.
+// (loading functions may throw exceptions if they fail; the first exception is rethrown once running functions finish.)
+// (throws if dependencies can't be satisfied -- e.g., if they form a cycle or name something that was never added.)
+// (each function's time, thread, and allocations are recorded for report_startup_timing())
+// (only call *once*, and not as well as start_load_functions())
 void call_load_functions();
 
+//Version of call_load_functions() for running without an OpenGL context (e.g., main.cpp's --headless mode):
+// only LoadAnyThread functions are called; LoadGLThread functions -- and anything that depends on them -- are skipped,
+//  so their Load<>s stay null.
+// (only call *once*, instead of call_load_functions() or start_load_functions())
+void call_load_functions_without_gl();
+
+//Asynchronous version of call_load_functions(), so frames can keep being drawn while loading (see LoadingMode.hpp):
+// starts running LoadAnyThread functions on worker threads and returns right away;
+// LoadGLThread functions are run a few at a time, whenever update() is called on the returned LoadProgress.
+// (only call *once*, and not as well as call_load_functions())
+struct LoadProgress;
+std::shared_ptr< LoadProgress > start_load_functions();
+
+struct LoadProgress {
+	//run LoadGLThread functions that are ready for (about) 'budget' seconds -- call from the GL thread, e.g. once per frame:
+	// (a negative budget waits until everything is loaded)
+	// (rethrows the first exception from a loading function once the functions running at the time finish;
+	//  throws if dependencies can't be satisfied)
+	void update(float budget);
+
+	size_t total() const; //number of loading functions
+	size_t finished() const; //number that have finished
+	bool done() const { return finished() == total(); }
+
+	//has the loading function added with 'key' (e.g., the address of a Load<>) finished?
+	bool loaded(void const *key) const;
+	//have all loading functions with tag 'tag' (and, so, earlier tags) finished?
+	bool loaded(LoadTag tag) const;
+
+	//(waits for any loading functions still running on worker threads)
+	~LoadProgress();
+
+	struct Schedule;
+	std::unique_ptr< Schedule > schedule;
+};
+
+
+//Run a LazyLoad's loading function (see below) now, on the calling thread, recording it like add_load_function()'s are:
+// (throws without calling fn if thread is LoadGLThread and the caller isn't the GL thread -- the one that called
+//  call_load_functions() or start_load_functions() -- or if there is no GL thread, e.g. after call_load_functions_without_gl())
+void call_lazy_load_function(LoadThread thread, std::function< void() > const &fn, char const *file, uint32_t line);
+
 
 //work-around for MSVC not accepting this as a lambda:
 template< typename T >
@@ -50,13 +124,17 @@ T const *new_T() { return new T; }
 template< typename T >
 struct Load {
 	//Constructing a Load< T > adds the passed function to the list of functions to call:
-	Load(LoadTag tag, const std::function< T const *() > &load_fn = new_T< T >) : value(nullptr) {
+	// (file and line are filled in with where the Load is constructed, to label it in startup timing reports)
+	Load(LoadTag tag, const std::function< T const *() > &load_fn = new_T< T >, char const *file = __builtin_FILE(), uint32_t line = __builtin_LINE())
+		: Load(tag, LoadOptions(), load_fn, file, line) { }
+	//...optionally saying what it depends on and whether it can run off the GL thread:
+	Load(LoadTag tag, LoadOptions const &options, const std::function< T const *() > &load_fn = new_T< T >, char const *file = __builtin_FILE(), uint32_t line = __builtin_LINE()) : value(nullptr) {
 		add_load_function(tag, [this,load_fn](){
 			this->value = load_fn();
 			if (!(this->value)) {
 				throw std::runtime_error("Loading failed.");
 			}
-		});
+		}, options, this, file, line);
 	}
 
 	//Make a "Load< T >" behave like a "T const *":
@@ -74,9 +152,80 @@ struct Load {
 template< >
 struct Load< void > {
 	//Constructing a Load< T > adds the passed function to the list of functions to call:
-	Load( LoadTag tag, const std::function< void() > &load_fn) {
-		add_load_function(tag, load_fn);
+	Load( LoadTag tag, const std::function< void() > &load_fn, char const *file = __builtin_FILE(), uint32_t line = __builtin_LINE()) {
+		add_load_function(tag, load_fn, LoadOptions(), this, file, line);
+	}
+	Load( LoadTag tag, LoadOptions const &options, const std::function< void() > &load_fn, char const *file = __builtin_FILE(), uint32_t line = __builtin_LINE()) {
+		add_load_function(tag, load_fn, options, this, file, line);
 	}
 };
 
 
+//LazyLoad< T > is a Load< T > that isn't loaded by call_load_functions(), but the first time it is used:
+// (so things only some modes need don't slow down startup)
+//
+// //at global scope:
+// LazyLoad< Sound > ending_music(LoadAnyThread, []() -> Sound const * { return new Sound(data_path("ending.opus")); });
+//
+// //when the ending is getting close -- starts loading on another thread (LoadAnyThread) or right away (LoadGLThread):
+// ending_music.prefetch();
+//
+// //later (waits for the prefetch to finish, or loads now if there wasn't one):
+// play(*ending_music);
+//
+//Using a LazyLoad from several threads is safe -- the loading function runs exactly once, and everyone else waits.
+// (if the loading function throws, the exception goes to whoever used the LazyLoad, and the next use tries again)
+//Like Load<>'s, the loading function is timed for the startup timing report, labelled with where the LazyLoad was constructed.
+//LoadGLThread LazyLoads may only be used on the GL thread; using one from any other thread throws instead of loading.
+template< typename T >
+struct LazyLoad {
+	LazyLoad(LoadThread thread_, const std::function< T const *() > &load_fn_ = new_T< T >, char const *file_ = __builtin_FILE(), uint32_t line_ = __builtin_LINE())
+		: thread(thread_), load_fn(load_fn_), file(file_), line(line_) { }
+	LazyLoad(const std::function< T const *() > &load_fn_ = new_T< T >, char const *file_ = __builtin_FILE(), uint32_t line_ = __builtin_LINE())
+		: LazyLoad(LoadGLThread, load_fn_, file_, line_) { }
+
+	//load (if it hasn't happened yet) and return the value:
+	// (double-checked with a mutex instead of std::call_once, since some std::call_once implementations hang
+	//  on the next call after the function throws)
+	T const *get() {
+		if (T const *loaded = value.load(std::memory_order_acquire)) return loaded;
+		std::lock_guard< std::mutex > lock(loading);
+		if (!value.load(std::memory_order_relaxed)) {
+			call_lazy_load_function(thread, [this](){
+				T const *loaded = load_fn();
+				if (!loaded) {
+					throw std::runtime_error("Loading failed.");
+				}
+				value.store(loaded, std::memory_order_release);
+			}, file, line);
+		}
+		return value.load(std::memory_order_relaxed);
+	}
+
+	//hint that the value will be needed soon:
+	// (only call from one thread at a time; errors are reported on first use, not here)
+	void prefetch() {
+		if (value.load() || prefetching.valid()) return;
+		if (thread == LoadAnyThread) {
+			prefetching = std::async(std::launch::async, [this](){ get(); });
+		} else {
+			try { get(); } catch (...) { }
+		}
+	}
+
+	//has it been loaded yet?
+	bool loaded() const { return value.load() != nullptr; }
+
+	//Make a "LazyLoad< T >" behave like a "T const *":
+	operator T const *() { return get(); }
+	T const &operator*() { return *get(); }
+	T const *operator->() { return get(); }
+
+	LoadThread thread;
+	std::function< T const *() > load_fn;
+	char const *file; //where the LazyLoad was constructed, to label it in startup timing reports
+	uint32_t line;
+	std::mutex loading; //held while load_fn runs
+	std::atomic< T const * > value{nullptr};
+	std::future< void > prefetching; //(waited for when the LazyLoad is destroyed)
+};
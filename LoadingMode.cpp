@@ -0,0 +1,67 @@
+#include "LoadingMode.hpp"
+
+#include "GL.hpp"
+
+//progress bar layout, in background tiles:
+static constexpr uint32_t BarLeft = 4;
+static constexpr uint32_t BarWidth = PPU466::ScreenWidth / 8 - 2 * BarLeft;
+static constexpr uint32_t BarRow = PPU466::ScreenHeight / 8 / 2;
+
+LoadingMode::LoadingMode(std::shared_ptr< LoadProgress > const &progress_, std::function< std::shared_ptr< Mode >() > const &make_next_)
+	: progress(progress_), make_next(make_next_) {
+
+	//palette 0 is the (empty) screen; palette 1 is the loaded part of the bar and palette 2 the rest:
+	ppu.background_color = glm::u8vec3(0x10, 0x10, 0x18);
+	ppu.palette_table[0] = {
+		glm::u8vec4(0x00, 0x00, 0x00, 0x00), glm::u8vec4(0x00, 0x00, 0x00, 0x00),
+		glm::u8vec4(0x00, 0x00, 0x00, 0x00), glm::u8vec4(0x00, 0x00, 0x00, 0x00),
+	};
+	ppu.palette_table[1] = {
+		glm::u8vec4(0x00, 0x00, 0x00, 0x00), glm::u8vec4(0xfb, 0xf2, 0x36, 0xff),
+		glm::u8vec4(0x00, 0x00, 0x00, 0x00), glm::u8vec4(0x00, 0x00, 0x00, 0x00),
+	};
+	ppu.palette_table[2] = {
+		glm::u8vec4(0x00, 0x00, 0x00, 0x00), glm::u8vec4(0x3f, 0x3f, 0x74, 0xff),
+		glm::u8vec4(0x00, 0x00, 0x00, 0x00), glm::u8vec4(0x00, 0x00, 0x00, 0x00),
+	};
+
+	//tile 0 is empty, tile 1 is solid color 1 with a one-pixel gap at the top and bottom:
+	ppu.tile_table[0].bit0 = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+	ppu.tile_table[0].bit1 = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+	ppu.tile_table[1].bit0 = { 0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00 };
+	ppu.tile_table[1].bit1 = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+
+	ppu.background.fill(0);
+}
+
+LoadingMode::~LoadingMode() {
+}
+
+void LoadingMode::update(float elapsed) {
+	if (progress->done()) {
+		timing.finish();
+		//(switching modes destroys this one, so hold on to it until update returns)
+		std::shared_ptr< Mode > self = shared_from_this();
+		Mode::set_current(make_next());
+	}
+}
+
+void LoadingMode::draw(glm::uvec2 const &drawable_size) {
+	//(once per frame, so each frame spends at most about 'budget' on loading, however many updates it had)
+	progress->update(budget);
+
+	//the PPU can't draw until its own resources have loaded:
+	if (!PPU466::can_draw(*progress)) {
+		glClearColor(ppu.background_color.r / 255.0f, ppu.background_color.g / 255.0f, ppu.background_color.b / 255.0f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT);
+		return;
+	}
+
+	size_t total = progress->total();
+	uint32_t filled = uint32_t(total ? BarWidth * progress->finished() / total : BarWidth);
+	for (uint32_t x = 0; x < BarWidth; ++x) {
+		ppu.background[BarRow * PPU466::BackgroundWidth + BarLeft + x] = 1 | (x < filled ? 1 : 2) << 8;
+	}
+
+	ppu.draw(drawable_size);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Mode.hpp"
+#include "PPU466.hpp"
+#include "Load.hpp"
+#include "startup_timing.hpp"
+
+#include <functional>
+#include <memory>
+
+/*
+ * LoadingMode keeps frames coming while loading functions run (see start_load_functions() in Load.hpp),
+ * showing a progress bar drawn with the PPU, so the window never stops responding during loading.
+ *
+ * Once everything has loaded, it switches to the mode returned by make_next:
+ *
+ * Mode::set_current(std::make_shared< LoadingMode >(start_load_functions(), [](){
+ *     return std::make_shared< PlayMode >();
+ * }));
+ *
+ * (the PPU's own resources load in LoadTagEarly, and the progress bar appears as soon as they're done -- see PPU466::can_draw)
+ */
+
+struct LoadingMode : Mode {
+	LoadingMode(std::shared_ptr< LoadProgress > const &progress, std::function< std::shared_ptr< Mode >() > const &make_next);
+	virtual ~LoadingMode();
+
+	virtual void update(float elapsed) override;
+	virtual void draw(glm::uvec2 const &drawable_size) override;
+
+	std::shared_ptr< LoadProgress > progress;
+	std::function< std::shared_ptr< Mode >() > make_next; //called once everything has loaded
+
+	//seconds per frame to spend running loading functions that need the GL thread:
+	// (these run from draw, which is called once per frame -- not from update, which slow frames call several times,
+	//  each of which would otherwise get a budget of its own; a single loading function can't be split up, though)
+	float budget = 0.004f;
+
+	//time spent loading, for the startup timing report:
+	StartupPhase timing = StartupPhase("LoadingMode (all loading functions)");
+
+	//----- drawing handled by PPU466 -----
+	PPU466 ppu;
+};
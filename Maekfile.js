@@ -80,13 +80,9 @@ let copies = [
 	maek.COPY(`${NEST_LIBS}/SDL2/dist/README-SDL.txt`, `dist/README-SDL.txt`),
 	maek.COPY(`${NEST_LIBS}/libpng/dist/README-libpng.txt`, `dist/README-libpng.txt`),
 
-	/* new assets created (.png files created in Aesprite) */
-	maek.COPY(`assets/bee-default.png`, `dist/assets/bee-default.png`),
-	maek.COPY(`assets/ground.png`, `dist/assets/ground.png`),
-	maek.COPY(`assets/maze-tiles.png`, `dist/assets/maze-tiles.png`),
+	/* new assets created (.png files created in Aesprite; tile sheets are baked into dist/assets/tiles.bin below) */
 	maek.COPY(`assets/palette_table_data.png`, `dist/assets/palette_table_data.png`),
 	maek.COPY(`assets/level-layout.png`, `dist/assets/level-layout.png`),
-	maek.COPY(`assets/light.png`, `dist/assets/light.png`),
 ];
 if (maek.OS === 'windows') {
 	copies.push( maek.COPY(`${NEST_LIBS}/SDL2/dist/SDL2.dll`, `dist/SDL2.dll`) );
@@ -107,17 +103,33 @@ if (maek.OS === 'windows') {
 // cppFile: name of c++ file to compile
 // objFileBase (optional): base name object file to produce (if not supplied, set to options.objDir + '/' + cppFile without the extension)
 //returns objFile: objFileBase + a platform-dependant suffix ('.o' or '.obj')
+const chunk_codecs_obj = maek.CPP('chunk_codecs.cpp');
+
+//objects shared between the game and the asset baking tools:
+const asset_objs = [
+	maek.CPP('load_save_png.cpp'),
+	maek.CPP('log.cpp'),
+	maek.CPP('asset_pipeline.cpp'),
+	maek.CPP('MappedFile.cpp'),
+	maek.CPP('ChunkBundle.cpp'),
+	chunk_codecs_obj,
+];
+
 const game_objs = [
-	maek.CPP('PlayMode.cpp'),
+	maek.CPP('PlayMode.cpp', undefined, { depends:[`tile_slots.hpp`] }), //(includes the header generated by bake-tiles)
 	maek.CPP('PPU466.cpp'),
+	maek.CPP('LoadingMode.cpp'),
 	maek.CPP('main.cpp'),
-	maek.CPP('load_save_png.cpp'),
 	maek.CPP('Load.cpp'),
 	maek.CPP('data_path.cpp'),
 	maek.CPP('Mode.cpp'),
 	maek.CPP('gl_compile_program.cpp'),
 	maek.CPP('GL.cpp'),
-	maek.CPP('asset_pipeline.cpp'),
+	maek.CPP('AssetWatcher.cpp'),
+	maek.CPP('startup_timing.cpp'),
+	maek.CPP('InputRecording.cpp'),
+	maek.CPP('frame_pacing.cpp'),
+	...asset_objs,
 ];
 
 //the '[exeFile =] LINK(objFiles, exeFileBase, [, options])' links an array of objects into an executable:
@@ -126,8 +138,40 @@ const game_objs = [
 //returns exeFile: exeFileBase + a platform-dependant suffix (e.g., '.exe' on windows)
 const game_exe = maek.LINK(game_objs, 'dist/game');
 
-//set the default target to the game (and copy the readme files):
-maek.TARGETS = [game_exe, ...copies];
+//decode throughput benchmark for chunk compression codecs (not built by default; run 'node Maekfile.js chunk-codec-bench'):
+const chunk_codec_bench_exe = maek.LINK([maek.CPP('chunk_codec_bench.cpp'), chunk_codecs_obj], 'chunk-codec-bench');
+
+//the '[dstFiles =] BAKE(toolExe, srcFiles, dstFiles [, args])' runs a tool to turn assets into runtime data:
+// toolExe: executable to run (e.g., the output of LINK)
+// srcFiles: array of files the tool reads
+// dstFiles: array of files the tool writes
+// args (optional): arguments to pass to the tool (default: srcFiles followed by dstFiles)
+//returns dstFiles
+//(outputs are only re-baked when the content of an input or of the tool changes; bakes run in parallel like other tasks)
+const bake_level_layout_exe = maek.LINK([maek.CPP('bake_level_layout.cpp'), ...asset_objs], 'bake-level-layout');
+
+const bake_tiles_exe = maek.LINK([maek.CPP('bake_tiles.cpp'), ...asset_objs], 'bake-tiles');
+
+//tile sheets to pack into the tile table, as Name:palette:file (palette is a PlayMode::PaletteTableIndex value);
+// slot indices for each sheet's tiles end up in tile_slots.hpp as TileSlots::Name
+const tile_sheets = [
+	`Ground:0:assets/ground.png`,
+	`Maze:1:assets/maze-tiles.png`,
+	`Player:3:assets/bee-default.png`,
+	`Light:4:assets/light.png`,
+];
+
+const baked = [
+	...maek.BAKE(bake_level_layout_exe, [`assets/level-layout.png`], [`dist/assets/level-layout.bin`]),
+	...maek.BAKE(bake_tiles_exe,
+		[`assets/palette_table_data.png`, ...tile_sheets.map(sheet => sheet.replace(/^[^:]*:[^:]*:/, ''))],
+		[`dist/assets/tiles.bin`, `tile_slots.hpp`],
+		[`assets/palette_table_data.png`, `dist/assets/tiles.bin`, `tile_slots.hpp`, ...tile_sheets]
+	),
+];
+
+//set the default target to the game (and copy the readme files + bake assets):
+maek.TARGETS = [game_exe, ...copies, ...baked];
 
 //======================================================================
 //Now, onward to the code that makes all this work:
@@ -389,6 +433,48 @@ function init_maek() {
 	};
 
 
+	//maek.BAKE runs a tool (usually one built by LINK) to process asset files into runtime data:
+	// toolExe is the executable to run (it is built first if there is a task for it)
+	// srcFiles is an array of input files; dstFiles is an array of output files
+	// args is the argument list for the tool (defaults to srcFiles followed by dstFiles)
+	//The outputs are re-used by content hash (like CPP and LINK), so they are only rebuilt when an input or the tool changes.
+	maek.BAKE = (toolExe, srcFiles, dstFiles, args = [...srcFiles, ...dstFiles], localOptions = {}) => {
+		const options = combineOptions(localOptions);
+
+		if (!Array.isArray(srcFiles)) throw new Error("BAKE: srcFiles should be an array.");
+		if (!Array.isArray(dstFiles)) throw new Error("BAKE: dstFiles should be an array.");
+
+		//run tools from this directory, not from the system path:
+		const command = [(toolExe.indexOf('/') === -1 ? './' + toolExe : toolExe), ...args];
+
+		const task = async () => {
+			for (const dstFile of dstFiles) {
+				await fsPromises.mkdir(path.dirname(dstFile), { recursive: true });
+			}
+			await run(command, `${task.label}: bake`,
+				async () => {
+					return {
+						read:[...srcFiles],
+						written:[...dstFiles]
+					};
+				}
+			);
+		};
+
+		task.depends = [toolExe, ...srcFiles, ...options.depends];
+		task.label = `BAKE ${dstFiles.join(', ')}`;
+
+		for (const dstFile of dstFiles) {
+			if (dstFile in maek.tasks) {
+				throw new Error(`Task ${task.label} purports to create ${dstFile}, but ${maek.tasks[dstFile].label} already creates that file.`);
+			}
+			maek.tasks[dstFile] = task;
+		}
+
+		return dstFiles;
+	};
+
+
 	//says something went wrong in building -- should fail loudly:
 	class BuildError extends Error {
 		constructor(message) {
@@ -576,6 +662,16 @@ function init_maek() {
 	// (used by run to figure out what to hash)
 	async function findExe(command) {
 		const osPath = require('path');
+		//commands given as a path (e.g., tools built by LINK) aren't looked up in PATH:
+		if (command[0].indexOf('/') !== -1) {
+			const exe = osPath.resolve(command[0]);
+			try {
+				await fsPromises.access(exe, fs.constants.X_OK);
+				return exe;
+			} catch (e) {
+				throw new BuildError(`Couldn't find file for command '${command[0]}'`);
+			}
+		}
 		let PATH;
 		if (maek.OS === 'windows') {
 			PATH = process.env.PATH.split(';');
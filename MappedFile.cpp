@@ -0,0 +1,99 @@
+#include "MappedFile.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(std::string const &filename) {
+	#if defined(_WIN32)
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		throw std::runtime_error("Failed to open file '" + filename + "' for mapping.");
+	}
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file, &file_size)) {
+		CloseHandle(file);
+		throw std::runtime_error("Failed to get size of file '" + filename + "'.");
+	}
+	file_handle = file;
+	size_ = size_t(file_size.QuadPart);
+	if (size_ == 0) return; //empty files can't be mapped, but are still valid (if boring)
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL) {
+		unmap();
+		throw std::runtime_error("Failed to create mapping of file '" + filename + "'.");
+	}
+	mapping_handle = mapping;
+	data_ = reinterpret_cast< uint8_t const * >(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	if (data_ == nullptr) {
+		unmap();
+		throw std::runtime_error("Failed to map view of file '" + filename + "'.");
+	}
+	#else
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0) {
+		throw std::runtime_error("Failed to open file '" + filename + "' for mapping.");
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		close(fd);
+		throw std::runtime_error("Failed to get size of file '" + filename + "'.");
+	}
+	size_ = size_t(st.st_size);
+	if (size_ == 0) { //empty files can't be mapped, but are still valid (if boring)
+		close(fd);
+		return;
+	}
+	void *mapped = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+	//the mapping holds its own reference to the file, so the descriptor isn't needed anymore:
+	close(fd);
+	if (mapped == MAP_FAILED) {
+		size_ = 0;
+		throw std::runtime_error("Failed to map file '" + filename + "'.");
+	}
+	data_ = reinterpret_cast< uint8_t const * >(mapped);
+	#endif
+}
+
+MappedFile::~MappedFile() {
+	unmap();
+}
+
+MappedFile::MappedFile(MappedFile &&other) {
+	*this = std::move(other);
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) {
+	if (this == &other) return *this;
+	unmap();
+	std::swap(data_, other.data_);
+	std::swap(size_, other.size_);
+	#ifdef _WIN32
+	std::swap(file_handle, other.file_handle);
+	std::swap(mapping_handle, other.mapping_handle);
+	#endif
+	return *this;
+}
+
+void MappedFile::unmap() {
+	#if defined(_WIN32)
+	if (data_) UnmapViewOfFile(data_);
+	if (mapping_handle) CloseHandle(mapping_handle);
+	if (file_handle) CloseHandle(file_handle);
+	mapping_handle = nullptr;
+	file_handle = nullptr;
+	#else
+	if (data_) munmap(const_cast< uint8_t * >(data_), size_);
+	#endif
+	data_ = nullptr;
+	size_ = 0;
+}
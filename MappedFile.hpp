@@ -0,0 +1,46 @@
+#pragma once
+
+/*
+ * A MappedFile is a read-only view of the contents of a file, backed by the OS's virtual memory system.
+ *
+ * Pages of the file are faulted in lazily as they are touched, so mapping a large file is cheap,
+ * and data can be used in place without allocating or copying:
+ *
+ * MappedFile level(data_path("assets/level-layout.bin"));
+ * size_t offset = 0;
+ * ChunkView< char > layout = view_chunk< char >(level, &offset, "Q_LL");
+ *
+ * (see read_write_chunk.hpp for view_chunk)
+ *
+ * Anything pointing into a MappedFile is only valid as long as the MappedFile is alive.
+ */
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+struct MappedFile {
+	MappedFile() = default;
+	//map the whole of 'filename' (throws on failure):
+	explicit MappedFile(std::string const &filename);
+	~MappedFile();
+
+	//a mapping has exactly one owner:
+	MappedFile(MappedFile const &) = delete;
+	MappedFile &operator=(MappedFile const &) = delete;
+	MappedFile(MappedFile &&);
+	MappedFile &operator=(MappedFile &&);
+
+	uint8_t const *data() const { return data_; }
+	size_t size() const { return size_; }
+
+private:
+	void unmap();
+
+	uint8_t const *data_ = nullptr;
+	size_t size_ = 0;
+	#ifdef _WIN32
+	void *file_handle = nullptr; //HANDLE returned by CreateFile
+	void *mapping_handle = nullptr; //HANDLE returned by CreateFileMapping
+	#endif
+};
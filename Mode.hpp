@@ -5,6 +5,8 @@
 
 #include <memory>
 
+struct PPU466;
+
 struct Mode : std::enable_shared_from_this< Mode > {
 	virtual ~Mode() { }
 
@@ -13,13 +15,26 @@ struct Mode : std::enable_shared_from_this< Mode > {
 	//The function should return 'true' if it handled the event.
 	virtual bool handle_event(SDL_Event const &, glm::uvec2 const &window_size) { return false; }
 
-	//update is called at the start of a new frame, after events are handled:
-	// 'elapsed' is time in seconds since the last call to 'update'
+	//update advances the simulation by one fixed step (see main.cpp), after events are handled:
+	// 'elapsed' is the length of the step in seconds (always Mode::Timestep)
+	// (depending on the frame rate, update may be called several times per frame, or not at all)
 	virtual void update(float elapsed) { }
+	static constexpr float Timestep = 1.0f / 120.0f;
 
-	//draw is called after update:
+	//draw is called once per frame, after any updates:
 	virtual void draw(glm::uvec2 const &drawable_size) = 0;
 
+	//how far (as a fraction of Timestep) the frame being drawn is past the most recent update:
+	// (set before each call to draw; drawing state interpolated this far from the previous update to the most recent one
+	//  looks smooth at any frame rate, at the cost of showing things up to one step late)
+	float interpolation_alpha = 1.0f;
+
+	//modes that draw only through a PPU466 may be updated on a separate simulation thread (main.cpp's --pipelined):
+	// such modes copy what draw would show into 'ppu' and return true; the main thread then draws that copy
+	// while the next updates run. (called after updates -- so, when pipelined, on the simulation thread)
+	//The default returns false: the mode is updated and drawn on the main thread.
+	virtual bool snapshot(PPU466 *ppu) { return false; }
+
 	//Mode::current is the Mode to which events are dispatched.
 	// use 'set_current' to change the current Mode (e.g., to switch to a menu)
 	static std::shared_ptr< Mode > current;
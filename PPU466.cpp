@@ -8,6 +8,8 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include <vector>
+#include <algorithm>
+#include <cstring>
 
 //In order to implement the PPU466 on modern graphics hardware, a fancy, special purpose tile-drawing shader is used:
 struct PPUTileProgram {
@@ -61,10 +63,15 @@ struct PPUDataStream {
 	GLuint palette_tex = 0;
 };
 
-Load< PPUDataStream > data_stream(LoadTagDefault);
+//(loaded early, along with tile_program -- which it uses -- so LoadingMode can draw while everything else loads)
+Load< PPUDataStream > data_stream(LoadTagEarly, LoadOptions{ LoadGLThread, { &tile_program } });
 
 //-------------------------------------------------------------------
 
+bool PPU466::can_draw(LoadProgress const &progress) {
+	return progress.loaded(&tile_program) && progress.loaded(&data_stream);
+}
+
 PPU466::PPU466() {
 	for (auto &palette : palette_table) {
 		palette[0] = glm::u8vec4(0x00, 0x00, 0x00, 0x00);
@@ -201,18 +208,33 @@ void PPU466::draw(glm::uvec2 const &drawable_size) const {
 	//-------------------------------------------------
 	//Upload at to GPU using PPUDataStream:
 
-	{ //upload palette texture:
+	//the textures keep their contents between frames, so only parts of the tables that changed since the last upload are re-sent:
+	// (this makes patching a few tiles or palettes -- e.g., when hot reloading assets -- cheap)
+	static bool uploaded = false; //have the textures been filled yet?
+
+	{ //upload palette texture (if it changed):
 		static_assert(sizeof(palette_table) == 4 * 4 * decltype(palette_table)().size(), "palette table is packed");
-		glBindTexture(GL_TEXTURE_2D, data_stream->palette_tex);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 4, GLsizei(palette_table.size()), 0, GL_RGBA, GL_UNSIGNED_BYTE, palette_table.data());
-		glBindTexture(GL_TEXTURE_2D, 0);
+		static std::array< Palette, 8 > uploaded_palette_table;
+		if (!uploaded || uploaded_palette_table != palette_table) {
+			glBindTexture(GL_TEXTURE_2D, data_stream->palette_tex);
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 4, GLsizei(palette_table.size()), GL_RGBA, GL_UNSIGNED_BYTE, palette_table.data());
+			glBindTexture(GL_TEXTURE_2D, 0);
+			uploaded_palette_table = palette_table;
+		}
 	}
 
-	{ //build + upload tile table texture:
+	{ //build + upload tile table texture (re-building only tiles that changed):
 		//interpret tiles and build a 128 x 128 index texture:
 		static std::array< uint8_t, 128 * 128 > data;
+		static std::array< Tile, 256 > uploaded_tile_table;
+		uint32_t changed_begin = uint32_t(tile_table.size()); //range of tiles that changed
+		uint32_t changed_end = 0;
 		for (uint32_t i = 0; i < tile_table.size(); ++i) {
 			Tile const &tile = tile_table[i];
+			if (uploaded && tile.bit0 == uploaded_tile_table[i].bit0 && tile.bit1 == uploaded_tile_table[i].bit1) continue;
+			uploaded_tile_table[i] = tile;
+			changed_begin = std::min(changed_begin, i);
+			changed_end = i + 1;
 
 			//location of tile in the texture:
 			uint32_t ox = (i % 16) * 8;
@@ -228,11 +250,18 @@ void PPU466::draw(glm::uvec2 const &drawable_size) const {
 			}
 		}
 
-		glBindTexture(GL_TEXTURE_2D, data_stream->tile_tex);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, 128, 128, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, data.data());
-		glBindTexture(GL_TEXTURE_2D, 0);
+		if (changed_begin < changed_end) {
+			//upload just the rows of the texture that hold changed tiles:
+			GLint row_begin = (changed_begin / 16) * 8;
+			GLint row_end = ((changed_end + 15) / 16) * 8;
+			glBindTexture(GL_TEXTURE_2D, data_stream->tile_tex);
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, row_begin, 128, row_end - row_begin, GL_RED_INTEGER, GL_UNSIGNED_BYTE, data.data() + 128 * row_begin);
+			glBindTexture(GL_TEXTURE_2D, 0);
+		}
 	}
 
+	uploaded = true;
+
 	{ //upload vertex data:
 		glBindBuffer(GL_ARRAY_BUFFER, data_stream->vertex_buffer);
 		glBufferData(GL_ARRAY_BUFFER, sizeof(decltype(triangle_strip[0])) * triangle_strip.size(), triangle_strip.data(), GL_STREAM_DRAW);
@@ -290,6 +319,101 @@ void PPU466::draw(glm::uvec2 const &drawable_size) const {
 }
 
 
+uint64_t PPU466::fingerprint() const {
+	//multiply-xorshift a 64-bit word at a time (the tables are ~12k, and this may be done every frame):
+	uint64_t hash = 0xcbf29ce484222325ull;
+	auto add_word = [&hash](uint64_t word) {
+		hash = (hash ^ word) * 0x9e3779b97f4a7c15ull;
+		hash ^= hash >> 32; //(multiplying only carries bits upward, so fold the high bits back down)
+	};
+	auto add = [&add_word](void const *data, size_t size) {
+		uint8_t const *bytes = reinterpret_cast< uint8_t const * >(data);
+		for (; size >= 8; bytes += 8, size -= 8) {
+			uint64_t word;
+			std::memcpy(&word, bytes, 8);
+			add_word(word);
+		}
+		uint64_t last = 0;
+		std::memcpy(&last, bytes, size);
+		add_word(last ^ (uint64_t(size) << 56));
+	};
+	add(&background_color, sizeof(background_color));
+	add(palette_table.data(), sizeof(palette_table));
+	add(tile_table.data(), sizeof(tile_table));
+	add(background.data(), sizeof(background));
+	add(&background_position, sizeof(background_position));
+	add(sprites.data(), sizeof(sprites));
+	return hash;
+}
+
+void PPU466::render_indexed(std::vector< uint8_t > *pixels_, std::vector< glm::u8vec4 > *palette_) const {
+	assert(pixels_);
+	assert(palette_);
+	auto &pixels = *pixels_;
+	auto &palette = *palette_;
+
+	palette.clear();
+	palette.reserve(1 + 4 * palette_table.size());
+	palette.emplace_back(glm::u8vec4(background_color, 0xff));
+	for (auto const &p : palette_table) {
+		palette.insert(palette.end(), p.begin(), p.end());
+	}
+
+	//background gets background color:
+	pixels.assign(ScreenWidth * ScreenHeight, 0);
+
+	//helper to put a single tile somewhere on the screen (clipped to the screen, or wrapped, like the background):
+	auto draw_tile = [this,&pixels](glm::ivec2 const &lower_left, uint8_t tile_index, uint8_t palette_index) {
+		Tile const &tile = tile_table[tile_index];
+		for (int32_t y = 0; y < 8; ++y) {
+			int32_t sy = lower_left.y + y;
+			if (sy < 0 || sy >= int32_t(ScreenHeight)) continue;
+			for (int32_t x = 0; x < 8; ++x) {
+				int32_t sx = lower_left.x + x;
+				if (sx < 0 || sx >= int32_t(ScreenWidth)) continue;
+				uint8_t color = ((tile.bit0[y] >> x) & 1) | ((tile.bit1[y] >> x) & 1) << 1;
+				if (palette_table[palette_index][color].a == 0) continue; //transparent
+				pixels[sx + sy * ScreenWidth] = uint8_t(1 + 4 * palette_index + color);
+			}
+		}
+	};
+
+	//same layering as draw(): 'behind' sprites, then the background, then 'in front' sprites:
+	auto draw_sprites = [this,&draw_tile](uint8_t priority) {
+		for (auto const &sprite : sprites) {
+			if ((sprite.attributes & 0x80) != priority) continue;
+			draw_tile(glm::ivec2(sprite.x, sprite.y), sprite.index, sprite.attributes & 0x07);
+		}
+	};
+
+	draw_sprites(0x80);
+
+	{ //draw the background, wrapped around so that it covers the screen:
+		constexpr int32_t BackgroundWidthPixels = int32_t(BackgroundWidth) * 8;
+		constexpr int32_t BackgroundHeightPixels = int32_t(BackgroundHeight) * 8;
+
+		//lower-left of the background, reduced to (-BackgroundWidthPixels,0] x (-BackgroundHeightPixels,0]:
+		glm::ivec2 pos = background_position;
+		pos.x = ((pos.x % BackgroundWidthPixels) - BackgroundWidthPixels) % BackgroundWidthPixels;
+		pos.y = ((pos.y % BackgroundHeightPixels) - BackgroundHeightPixels) % BackgroundHeightPixels;
+
+		for (int32_t oy : {pos.y, pos.y + BackgroundHeightPixels}) {
+			for (int32_t ox : {pos.x, pos.x + BackgroundWidthPixels}) {
+				for (int32_t y = 0; y < int32_t(BackgroundHeight); ++y) {
+					if (oy + 8*y + 8 <= 0 || oy + 8*y >= int32_t(ScreenHeight)) continue;
+					for (int32_t x = 0; x < int32_t(BackgroundWidth); ++x) {
+						if (ox + 8*x + 8 <= 0 || ox + 8*x >= int32_t(ScreenWidth)) continue;
+						uint16_t info = background[x + BackgroundWidth * y];
+						draw_tile(glm::ivec2(ox + 8*x, oy + 8*y), info & 0xff, (info >> 8) & 0x07);
+					}
+				}
+			}
+		}
+	}
+
+	draw_sprites(0x00);
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
 PPUTileProgram::PPUTileProgram() {
@@ -7,6 +7,9 @@
 
 #include <glm/glm.hpp>
 #include <array>
+#include <vector>
+
+struct LoadProgress;
 
 struct PPU466 {
 	PPU466();
@@ -18,6 +21,20 @@ struct PPU466 {
 	// pass the size of the current framebuffer in pixels so it knows how to scale itself
 	void draw(glm::uvec2 const &drawable_size) const;
 
+	//draw() can only be called once the PPU's own GL resources have been loaded by their loading functions:
+	// (so, e.g., LoadingMode can start drawing while everything else is still loading)
+	static bool can_draw(LoadProgress const &progress);
+
+	//alternatively, render on the CPU (no GL needed) at native resolution:
+	// pixels gets ScreenWidth x ScreenHeight indices into 'palette', in rows from bottom-to-top
+	// palette gets the background color (index 0) followed by every palette table entry (index 1 + 4 * palette + color)
+	//NOTE: unlike draw(), there is no blending -- colors with alpha == 0 are transparent, all others are opaque
+	void render_indexed(std::vector< uint8_t > *pixels, std::vector< glm::u8vec4 > *palette) const;
+
+	//hash of everything below, so it's cheap to check whether anything that would be drawn has changed:
+	// (equal fingerprints mean -- barring a very unlikely collision -- that draw() would produce the same image)
+	uint64_t fingerprint() const;
+
 	//--------------------------------------------------------------
 	//Set the values below to control the PPU's drawing:
 
@@ -8,213 +8,254 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include <unordered_set>
+#include <chrono>
+#include <cmath>
 
 #include "data_path.hpp"
+#include "Load.hpp"
+#include "log.hpp"
 #include "load_save_png.hpp"
-#include "read_write_chunk.hpp"
+#include "ChunkBundle.hpp"
 
 #include "asset_pipeline.hpp"
+#include "tile_slots.hpp"
 
 
-void PlayMode::illuminate_quadrant(uint8_t quadrant) {
-    for (size_t i = 0; i < quadrant_height; i++) {
-        for (size_t j = 0; j < quadrant_width; j++) {
-            size_t quadrant_pixel = (i * quadrant_width) + j;
-            size_t background_pixel = start_idxs[quadrant] + (i * PPU466::BackgroundWidth) + j;
-
-            if (quadrant_chunks[quadrant][quadrant_pixel] == '1') {
-                /* clear the palette bits to be 0 (preserve the tile index bits) */
-                ppu.background[background_pixel] &= 0b11111111;
+/* the 8 pixel cells that the open interval (lo, hi) overlaps, clamped to [0, count) (empty if first > last) */
+static void cells_overlapping(float lo, float hi, int32_t count, int32_t *first, int32_t *last) {
+    *first = std::max(int32_t(std::floor(lo / 8.0f)), 0);
+    *last = std::min(int32_t(std::ceil(hi / 8.0f)) - 1, count - 1);
+}
 
-                /* swap the palette */
-                ppu.background[background_pixel] |= MazeLitPalette << 8;
-            }
+float PlayMode::sweep_x(glm::vec2 min, glm::vec2 max, float distance) const {
+    /* walls in any of the rows the box spans, as one column bitmask */
+    int32_t row_first, row_last;
+    cells_overlapping(min.y, max.y, int32_t(PPU466::BackgroundHeight), &row_first, &row_last);
+    uint64_t walls = 0;
+    for (int32_t i = row_first; i <= row_last; i++) walls |= maze_rows[i];
+
+    /* walk the columns the leading edge passes into, nearest first, and stop at the first wall */
+    if (distance > 0.0f) {
+        int32_t first = std::max(int32_t(std::ceil(max.x / 8.0f)), 0);
+        int32_t last = std::min(int32_t(std::ceil((max.x + distance) / 8.0f)) - 1, int32_t(PPU466::BackgroundWidth) - 1);
+        for (int32_t j = first; j <= last; j++) {
+            if ((walls >> j) & 1) return std::max(0.0f, 8.0f * j - max.x);
+        }
+    } else if (distance < 0.0f) {
+        int32_t first = std::min(int32_t(std::floor(min.x / 8.0f)) - 1, int32_t(PPU466::BackgroundWidth) - 1);
+        int32_t last = std::max(int32_t(std::floor((min.x + distance) / 8.0f)), 0);
+        for (int32_t j = first; j >= last; j--) {
+            if ((walls >> j) & 1) return std::min(0.0f, 8.0f * j + 8.0f - min.x);
         }
     }
+    return distance;
 }
 
-void PlayMode::draw_quadrant(uint8_t quadrant) {
-    for (size_t i = 0; i < quadrant_height; i++) {
-        for (size_t j = 0; j < quadrant_width; j++) {
-            size_t quadrant_pixel = (i * quadrant_width) + j;
-            size_t background_pixel = start_idxs[quadrant] + (i * PPU466::BackgroundWidth) + j;
-
-            auto has_maze_tile_Up = [this, &quadrant, &quadrant_pixel]() {
-                return quadrant_chunks[quadrant][quadrant_pixel - quadrant_width] == '1';
-            };
-            auto has_maze_tile_Down = [this, &quadrant, &quadrant_pixel]() {
-                return quadrant_chunks[quadrant][quadrant_pixel + quadrant_width] == '1';
-            };
-            auto has_maze_tile_Left = [this, &quadrant, &quadrant_pixel]() {
-                return quadrant_chunks[quadrant][quadrant_pixel - 1] == '1';
-            };
-            auto has_maze_tile_Right = [this, &quadrant, &quadrant_pixel]() {
-                return quadrant_chunks[quadrant][quadrant_pixel + 1] == '1';
-            };
-
-            if (quadrant_chunks[quadrant][quadrant_pixel] == '1') {
-                /* based on the surrounding tiles, determines which maze tile to draw
-                 * currently, this implementation doesn't check across the quadrant borders, so those will all have edges
-                 *      even if they shouldn't but it's good enough for now
-                 * Also the edge cases are a little bit hard-coded and not good at the moment */
-                uint8_t tile_table_idx;
-
-                /* edges of quadrant, kind of hard-codey*/
-                if (i == 0 || i == quadrant_height - 1 || j == 0 || j == quadrant_width - 1) {
-                    if (i == 0) { /* top edge of quadrant */
-                        if (j == 0 || !(has_maze_tile_Left())) tile_table_idx = 7;
-                        else if (j == quadrant_width - 1 || !(has_maze_tile_Right())) tile_table_idx = 9;
-                        else tile_table_idx = 8;
-                    }
-                    else if (i == quadrant_height - 1) { /* bottom edge of quadrant */
-                        if (j == 0 || !(has_maze_tile_Left())) tile_table_idx = 1;
-                        else if (j == quadrant_width - 1 || !(has_maze_tile_Right())) tile_table_idx = 3;
-                        else tile_table_idx = 2;
-                    }
-                    else if (j == 0) { /* left edge of quadrant */
-                        if (!(has_maze_tile_Up())) tile_table_idx = 7;
-                        else if (!(has_maze_tile_Down())) tile_table_idx = 1;
-                        else tile_table_idx = 4;
-                    }
-                    else { /* right edge of quadrant */
-                        if (!(has_maze_tile_Up())) tile_table_idx = 9;
-                        else if (!(has_maze_tile_Down())) tile_table_idx = 3;
-                        else tile_table_idx = 6;
-                    }
-                }
-                else { /* not corners, still not very pretty code, but it works so it's good enough, yay stupid code */
-                    if (has_maze_tile_Down() && has_maze_tile_Up() && has_maze_tile_Left() && has_maze_tile_Right()) tile_table_idx = 5;
-                    else if (has_maze_tile_Up() && has_maze_tile_Down()) {
-                        /* just left or just right */
-                        if (has_maze_tile_Right()) tile_table_idx = 4;
-                        else tile_table_idx = 6;
-                    }
-                    else if (has_maze_tile_Up()) {
-                        /* One of the bottom ones, 1-3 */
-                        if (has_maze_tile_Left() && has_maze_tile_Right()) tile_table_idx = 2;
-                        else if (has_maze_tile_Right()) tile_table_idx = 1;
-                        else  tile_table_idx = 3;
-                    }
-                    else {
-                        /* One of the top ones, 7-9 */
-                        if (has_maze_tile_Left() && has_maze_tile_Right()) tile_table_idx = 8;
-                        else if (has_maze_tile_Right()) tile_table_idx = 7;
-                        else tile_table_idx = 9;
-                    }
-                }
-
-                /* set the maze tile */
-                ppu.background[background_pixel] = tile_table_idx | MazeUnlitPalette << 8;
-            }
-            else {
-                ppu.background[background_pixel] = 0 | GroundPalette << 8;
-            }
+float PlayMode::sweep_y(glm::vec2 min, glm::vec2 max, float distance) const {
+    /* the columns the box spans, as a bitmask to test each row's walls against */
+    int32_t column_first, column_last;
+    cells_overlapping(min.x, max.x, int32_t(PPU466::BackgroundWidth), &column_first, &column_last);
+    if (column_first > column_last) return distance;
+    uint32_t count = uint32_t(column_last - column_first + 1);
+    uint64_t columns = (count == 64 ? ~uint64_t(0) : ((uint64_t(1) << count) - 1)) << column_first;
+
+    if (distance > 0.0f) {
+        int32_t first = std::max(int32_t(std::ceil(max.y / 8.0f)), 0);
+        int32_t last = std::min(int32_t(std::ceil((max.y + distance) / 8.0f)) - 1, int32_t(PPU466::BackgroundHeight) - 1);
+        for (int32_t i = first; i <= last; i++) {
+            if (maze_rows[i] & columns) return std::max(0.0f, 8.0f * i - max.y);
+        }
+    } else if (distance < 0.0f) {
+        int32_t first = std::min(int32_t(std::floor(min.y / 8.0f)) - 1, int32_t(PPU466::BackgroundHeight) - 1);
+        int32_t last = std::max(int32_t(std::floor((min.y + distance) / 8.0f)), 0);
+        for (int32_t i = first; i >= last; i--) {
+            if (maze_rows[i] & columns) return std::min(0.0f, 8.0f * i + 8.0f - min.y);
         }
     }
+    return distance;
 }
 
-PlayMode::PlayMode() {
-    ppu.background = {};
-    ppu.palette_table = {};
-    ppu.tile_table = {};
+void PlayMode::illuminate_quadrant(uint8_t quadrant) {
+    /* row and column of quadrant */
+    uint8_t r = quadrant >> 1;
+    uint8_t c = quadrant & 1;
 
-    { /* (1) Populating the PPU's palette table
-       * Uses palette_table_data.png as a storage format for all 8 palettes in palette table
-       * Inspired by Matei Budiu's implementation of individual palettes as their own 2x2 png files
-       * Palette colors are taken from Aesprite default RGB palette (at least for now until I look for other colors) */
-        std::vector<glm::u8vec4> palette_table_data;
-        glm::uvec2 palette_table_size;
-        load_png(data_path("assets/palette_table_data.png"), &palette_table_size, &palette_table_data, UpperLeftOrigin);
-        assert(palette_table_size == glm::uvec2(4, 8));
-
-        for (size_t i = 0; i < 8; i++) { // looping over each palette in table
-            size_t current_start_idx = 4 * i;
-
-            PPU466::Palette current_palette = {};
-            for (size_t j = 0; j < 4; j++) { // looping over each color in palette
-                current_palette[j] = palette_table_data[current_start_idx + j];
-            }
+    uint64_t column_mask = ((uint64_t(1) << QuadrantWidth) - 1) << (c * QuadrantWidth);
+    for (size_t i = r * QuadrantHeight; i < (r + 1) * QuadrantHeight; i++) {
+        lit_rows[i] |= maze_rows[i] & column_mask;
+    }
+
+    draw_maze(r * QuadrantHeight, (r + 1) * QuadrantHeight);
+}
 
-            ppu.palette_table[i] = current_palette;
+void PlayMode::draw_maze(size_t row_begin, size_t row_end) {
+    assert(row_begin <= row_end && row_end <= PPU466::BackgroundHeight);
+    for (size_t i = row_begin; i < row_end; i++) {
+        /* based on the surrounding tiles, determines which maze tile to draw, for the whole row at once
+         * (anything outside of the background counts as ground) */
+        uint64_t wall = maze_rows[i];
+        uint64_t below = (i > 0 ? maze_rows[i - 1] : 0);
+        uint64_t above = (i + 1 < PPU466::BackgroundHeight ? maze_rows[i + 1] : 0);
+        uint64_t left = wall << 1; /* bit j set if there's a wall at j - 1 */
+        uint64_t right = wall >> 1; /* bit j set if there's a wall at j + 1 */
+        uint64_t sides = left & right;
+
+        /* maze tiles 1-3 are the tops of walls, 4-6 the middles, and 7-9 the bottoms
+         * (these are positions in the maze sheet; TileSlots::Maze gives their slots in the tile table) */
+        uint64_t top = wall & below & ~above;
+        uint64_t middle = wall & below & above;
+        uint64_t bottom = wall & ~below;
+
+        std::array< uint64_t, 10 > tile_masks = {};
+        tile_masks[1] = top & right & ~left;
+        tile_masks[2] = top & sides;
+        tile_masks[3] = top & ~right;
+        tile_masks[4] = middle & right & ~sides;
+        tile_masks[5] = middle & sides;
+        tile_masks[6] = middle & ~right;
+        tile_masks[7] = bottom & right & ~left;
+        tile_masks[8] = bottom & sides;
+        tile_masks[9] = bottom & ~right;
+
+        /* split the tile indices into bit planes so each cell's index can be read off with shifts */
+        uint64_t index_bit0 = 0, index_bit1 = 0, index_bit2 = 0, index_bit3 = 0;
+        for (uint8_t t = 1; t < tile_masks.size(); t++) {
+            if (t & 1) index_bit0 |= tile_masks[t];
+            if (t & 2) index_bit1 |= tile_masks[t];
+            if (t & 4) index_bit2 |= tile_masks[t];
+            if (t & 8) index_bit3 |= tile_masks[t];
         }
 
-        /* Setting the background color to same color as ground's primary color */
-        ppu.background_color = ppu.palette_table[GroundPalette][2];
+        for (size_t j = 0; j < PPU466::BackgroundWidth; j++) {
+            size_t background_pixel = (i * PPU466::BackgroundWidth) + j;
+            if ((wall >> j) & 1) {
+                uint8_t maze_tile = uint8_t(((index_bit0 >> j) & 1) | ((index_bit1 >> j) & 1) << 1
+                                          | ((index_bit2 >> j) & 1) << 2 | ((index_bit3 >> j) & 1) << 3);
+                uint16_t tile_table_idx = TileSlots::Maze[maze_tile - 1];
+                uint16_t palette = ((lit_rows[i] >> j) & 1) ? MazeLitPalette : MazeUnlitPalette;
+                ppu.background[background_pixel] = tile_table_idx | palette << 8;
+            } else {
+                ppu.background[background_pixel] = TileSlots::Ground | GroundPalette << 8;
+            }
+        }
     }
+}
 
-    { /* (2) Processing png spritesheets for all the background tiles */
-        {/* Default ground tile (non-maze) */
-            std::vector<glm::u8vec4> ground_data;
-            glm::uvec2 ground_size;
-            load_png(data_path("assets/ground.png"), &ground_size, &ground_data, LowerLeftOrigin);
-            assert(ground_size == glm::uvec2(8, 8));
+typedef decltype(PPU466::palette_table) PaletteTable;
+typedef decltype(PPU466::tile_table) TileTable;
+
+static PaletteTable read_palette_table() {
+    /* Uses palette_table_data.png as a storage format for all 8 palettes in palette table
+     * Inspired by Matei Budiu's implementation of individual palettes as their own 2x2 png files
+     * Palette colors are taken from Aesprite default RGB palette (at least for now until I look for other colors) */
+    std::vector< glm::u8vec4 > palette_table_data;
+    glm::uvec2 palette_table_size;
+    load_png(data_path("assets/palette_table_data.png"), &palette_table_size, &palette_table_data, UpperLeftOrigin);
+    return generate_palette_table_from_data(palette_table_data, palette_table_size);
+}
 
-            PPU466::Tile ground_tile = generate_tile_from_data(ground_data, ppu.palette_table[GroundPalette]);
-            ppu.tile_table[0] = ground_tile;
+static TileTable read_tile_table() {
+    /* All the tile sheets (ground, maze, player, light) are packed into the tile table by the bake-tiles tool,
+     * which drops duplicate tiles and writes the slot it gave each tile to tile_slots.hpp */
+    ChunkBundle tiles(data_path("assets/tiles.bin"));
+    ChunkView< PPU466::Tile > packed = tiles.view< PPU466::Tile >(fourcc("TILE"));
+    if (packed.size() != TileSlots::Count) {
+        throw std::runtime_error("Packed tile table doesn't match tile_slots.hpp (rebuild the game to pick up new tile slots).");
+    }
+    TileTable tile_table = {};
+    std::copy(packed.begin(), packed.end(), tile_table.begin());
+    return tile_table;
+}
 
-            for (size_t i = 0; i < ppu.background.size(); i++) {
-                ppu.background[i] = 0 | GroundPalette << 8;
-            }
+/* Assets are read on loading worker threads (while LoadingMode draws its progress bar); PlayMode's constructor just copies them in.
+ * (none of these need the PPU's GL resources, so they're in LoadTagEarly to start right away, alongside those) */
+static Load< PaletteTable > palette_table_asset(LoadTagEarly, LoadOptions{ LoadAnyThread }, [](){
+    return new PaletteTable(read_palette_table());
+});
+
+static Load< TileTable > tile_table_asset(LoadTagEarly, LoadOptions{ LoadAnyThread }, [](){
+    return new TileTable(read_tile_table());
+});
+
+static Load< PlayMode::MazeRows > maze_rows_asset(LoadTagEarly, LoadOptions{ LoadAnyThread }, [](){
+    /* the wall bitmasks for every row of the background */
+    ChunkBundle level_layout(data_path("assets/level-layout.bin"));
+    ChunkView< uint64_t > rows = level_layout.view< uint64_t >(fourcc("MAZE"));
+    PlayMode::MazeRows *maze_rows = new PlayMode::MazeRows;
+    if (rows.size() != maze_rows->size()) {
+        delete maze_rows;
+        throw std::runtime_error("Level layout doesn't have one row per background row.");
+    }
+    std::copy(rows.begin(), rows.end(), maze_rows->begin());
+    return maze_rows;
+});
+
+/* (set up along with the other assets, so PlayMode can take it over; if watching fails, the game just doesn't hot reload)
+ * (on the GL thread -- it's quick -- so that it's skipped in --headless runs, which shouldn't reload assets mid-benchmark) */
+static AssetWatcher loaded_asset_watcher;
+static Load< void > asset_watcher_setup(LoadTagEarly, LoadOptions{ LoadGLThread }, [](){
+    try {
+        loaded_asset_watcher = AssetWatcher(data_path("assets"));
+    } catch (std::exception const &e) {
+        LOG_WARNING("Asset hot reload disabled: {}", e.what());
+    }
+});
+
+size_t PlayMode::set_palette_table(PaletteTable const &palette_table) {
+    size_t changed = 0;
+    for (size_t i = 0; i < palette_table.size(); i++) {
+        if (ppu.palette_table[i] != palette_table[i]) {
+            ppu.palette_table[i] = palette_table[i];
+            changed++;
         }
+    }
 
-        {/* 8 distinct tiles for all the maze edges
-          * Stored in tile_table indices 1-9 (inclusive) */
-            std::vector<glm::u8vec4> maze_data;
-            glm::uvec2 maze_size;
-            load_png(data_path("assets/maze-tiles.png"), &maze_size, &maze_data, LowerLeftOrigin);
-            assert(maze_size == glm::uvec2(24, 24));
-
-            std::vector< PPU466::Tile > maze_tiles = generate_tiles_from_spritesheet(maze_data, maze_size,ppu.palette_table[MazeLitPalette]);
+    /* Setting the background color to same color as ground's primary color */
+    ppu.background_color = ppu.palette_table[GroundPalette][2];
+    return changed;
+}
 
-            /* Copy over generated maze tiles into the tile table */
-            size_t current_tile_table_idx = 1;
-            for (PPU466::Tile const &maze_tile : maze_tiles) {
-                ppu.tile_table[current_tile_table_idx] = maze_tile;
-                current_tile_table_idx++;
-            }
+size_t PlayMode::set_tile_table(TileTable const &tile_table) {
+    size_t changed = 0;
+    for (size_t i = 0; i < tile_table.size(); i++) {
+        PPU466::Tile &tile = ppu.tile_table[i];
+        if (tile.bit0 != tile_table[i].bit0 || tile.bit1 != tile_table[i].bit1) {
+            tile = tile_table[i];
+            changed++;
         }
     }
+    return changed;
+}
 
-    { /* (3) Setting up background tiles and their palettes using level layout binary */
-        /* Read the chunks for all 4 quadrants and finding their start pixels in background */
-        std::ifstream level_layout_binary(data_path("assets/level-layout.bin"), std::ios::binary);
-        for (uint8_t i = 0; i < 4; i++) {
-            read_chunk(level_layout_binary, magic_values[i], &quadrant_chunks[i]);
+PlayMode::PlayMode() {
+    ppu.background = {};
+    ppu.palette_table = {};
+    ppu.tile_table = {};
 
-            /* row and column of quadrants */
-            uint8_t r = i >> 1;
-            uint8_t c = i & 1;
+    /* (1) Populating the PPU's palette table + (2) the tile table */
+    set_palette_table(*palette_table_asset);
+    set_tile_table(*tile_table_asset);
 
-            start_idxs[i] = (r * quadrant_height * PPU466::BackgroundWidth) + (c * quadrant_width);
-        }
+    for (size_t i = 0; i < ppu.background.size(); i++) {
+        ppu.background[i] = TileSlots::Ground | GroundPalette << 8;
+    }
+
+    { /* (3) Setting up background tiles and their palettes using level layout binary */
+        maze_rows = *maze_rows_asset;
 
-        /* Draw each quadrant, initially unlit */
-        for (uint8_t i = 0; i < 4; i++) draw_quadrant(i);
+        /* Draw the maze, initially unlit */
+        draw_maze(0, PPU466::BackgroundHeight);
     }
 
     { /* Player Sprite */
-        //use tile 32 as a "player":
-        std::vector<glm::u8vec4> player_data;
-        glm::uvec2 player_size;
-        load_png(data_path("assets/bee-default.png"), &player_size, &player_data, LowerLeftOrigin);
-        PPU466::Tile player_tile = generate_tile_from_data(player_data, ppu.palette_table[PlayerPalette]);
-        ppu.tile_table[32] = player_tile;
-
-        //player sprite:
         player_at = glm::vec2(32.0f, 216.0f); /* starting game position */
-        ppu.sprites[32].index = 32;
+        player_was = player_at;
+        ppu.sprites[32].index = TileSlots::Player;
         ppu.sprites[32].attributes = PlayerPalette;
     }
 
 
     { /* Other Sprites */
-        //use sprite 12 as a "light":
-        std::vector<glm::u8vec4> light_data;
-        glm::uvec2 light_size;
-        load_png(data_path("assets/light.png"), &light_size, &light_data, LowerLeftOrigin);
-        PPU466::Tile light_tile = generate_tile_from_data(light_data, ppu.palette_table[LightPalette]);
-        ppu.tile_table[12] = light_tile;
-
         /* Set the coordinates of the lights here (this part is hard-coded for now but there are only 4 values)
          * In the future, these should probably get read off another PNG file (along with flower sprites) */
         std::array< glm::uvec2, 4 > light_positions = {glm::uvec2(20, 20), glm::uvec2(164, 70),
@@ -222,17 +263,25 @@ PlayMode::PlayMode() {
 
         //4 light sprites in sprite table (take up sprite index 0-3, corresponding to their quadrant):
         for (size_t i = 0; i < 4; i++) {
-            ppu.sprites[i].index = 12;
+            ppu.sprites[i].index = TileSlots::Light;
             ppu.sprites[i].attributes = LightPalette;
             ppu.sprites[i].x = light_positions[i].x;
             ppu.sprites[i].y = light_positions[i].y;
         }
     }
+
+    { /* Hot reloading: watch the baked assets, so rebuilding them while the game runs updates it in place */
+        asset_watcher = std::move(loaded_asset_watcher);
+    }
 }
 
 PlayMode::~PlayMode() {
 }
 
+bool PlayMode::is_game_key(SDL_Keycode key) {
+    return key == SDLK_LEFT || key == SDLK_RIGHT || key == SDLK_UP || key == SDLK_DOWN || key == SDLK_e || key == SDLK_q;
+}
+
 bool PlayMode::handle_event(SDL_Event const &evt, glm::uvec2 const &window_size) {
     if (evt.type == SDL_KEYDOWN) {
         if (evt.key.keysym.sym == SDLK_LEFT) {
@@ -259,6 +308,17 @@ bool PlayMode::handle_event(SDL_Event const &evt, glm::uvec2 const &window_size)
             Q.downs += 1;
             Q.pressed = true;
             return true;
+        } else if (evt.key.keysym.sym == SDLK_F12) {
+            /* save the last drawn frame at native resolution, as a (small, quick to encode) paletted png */
+            static uint32_t saved_frames = 0;
+            std::string filename = "frame-" + std::to_string(saved_frames++) + ".png";
+            LOG_INFO("Saving frame to '{}'.", filename);
+
+            std::vector< uint8_t > pixels;
+            std::vector< glm::u8vec4 > palette;
+            ppu.render_indexed(&pixels, &palette);
+            save_png_indexed(filename, glm::uvec2(PPU466::ScreenWidth, PPU466::ScreenHeight), pixels.data(), palette, LowerLeftOrigin);
+            return true;
         }
 
     } else if (evt.type == SDL_KEYUP) {
@@ -292,6 +352,9 @@ void PlayMode::update(float elapsed) {
     constexpr float PlayerSize = 8.0f;
     constexpr float map_margin = 16.0f;
     constexpr float obj_margin = 8.0f;
+
+    player_was = player_at;
+
     float distAttempted = PlayerSpeed * elapsed;
     float new_x = player_at.x;
     float new_y = player_at.y;
@@ -329,28 +392,10 @@ void PlayMode::update(float elapsed) {
     if (down.pressed) new_y = std::max(player_at.y - distAttempted, map_margin + 1); // so bee doesn't touch the ground
     if (up.pressed) new_y = std::min(player_at.y + distAttempted, PPU466::ScreenHeight - map_margin - PlayerSize);
 
-    auto player_overlapping_collider = [this, &objects_overlap, &new_x, &new_y](){
-        /* Check collision with background maze tiles */
-        for (size_t i = 0; i < ppu.BackgroundHeight; i++) {
-            for (size_t j = 0; j < ppu.BackgroundWidth; j++) {
-                size_t current_pixel_x = j * 8;
-                size_t current_pixel_y = i * 8;
-                size_t current_tile_idx = (i * ppu.BackgroundWidth) + j;
-                if (((ppu.background[current_tile_idx] & 0b11111111) > 0 && (ppu.background[current_tile_idx] & 0b11111111) < 10)
-                  && objects_overlap(new_x, new_y, PlayerSize, (float)current_pixel_x, (float)current_pixel_y, 8, 1.0f)) {
-                    std::cout << "Hitting the collider at pixel (" << current_pixel_x << ", " << current_pixel_y << ")\n";
-                    std::cout << "current pixel index is" << current_tile_idx;
-                    return true;
-                }
-            }
-        }
-        return false;
-    };
-
-    if (!player_overlapping_collider()) {
-        player_at.x = new_x;
-        player_at.y = new_y;
-    }
+    /* Move against the maze walls (with a 1 pixel margin) one axis at a time, stopping flush with any wall in the way --
+     * so a blocked direction doesn't cancel the other one (the player slides along walls), and a long step can't pass through one */
+    player_at.x += sweep_x(player_at - glm::vec2(1.0f), player_at + glm::vec2(PlayerSize + 1.0f), new_x - player_at.x);
+    player_at.y += sweep_y(player_at - glm::vec2(1.0f), player_at + glm::vec2(PlayerSize + 1.0f), new_y - player_at.y);
 
     /* handle interactions with sprite objects */
     if (E.pressed) {
@@ -375,13 +420,57 @@ void PlayMode::update(float elapsed) {
     down.downs = 0;
 }
 
-void PlayMode::draw(glm::uvec2 const &drawable_size) {
-    //--- set ppu state based on game state ---
+void PlayMode::reload_changed_assets() {
+    /* (only the changed entries get patched into the PPU) */
+    for (std::string const &name : asset_watcher.poll()) {
+        auto before = std::chrono::high_resolution_clock::now();
+        size_t changed;
+        try {
+            if (name == "palette_table_data.png") changed = set_palette_table(read_palette_table());
+            else if (name == "tiles.bin") changed = set_tile_table(read_tile_table());
+            else continue;
+        } catch (std::exception const &e) {
+            LOG_WARNING("Failed to reload '{}': {}", name, e.what());
+            continue;
+        }
+        float ms = std::chrono::duration< float, std::milli >(std::chrono::high_resolution_clock::now() - before).count();
+        LOG_INFO("Reloaded '{}' in {} ms ({} entries changed).", name, ms, changed);
+    }
+}
 
-    //player sprite:
-    ppu.sprites[32].x = int8_t(player_at.x);
-    ppu.sprites[32].y = int8_t(player_at.y);
+void PlayMode::draw(glm::uvec2 const &drawable_size) {
+    reload_changed_assets();
+    update_ppu();
 
     //--- actually draw ---
     ppu.draw(drawable_size);
 }
+
+bool PlayMode::snapshot(PPU466 *ppu_) {
+    reload_changed_assets();
+    update_ppu();
+    *ppu_ = ppu;
+    return true;
+}
+
+uint64_t PlayMode::state_checksum() const {
+    /* FNV-1a over everything update() changes: the player's position and which walls have been lit */
+    uint64_t hash = 0xcbf29ce484222325ull;
+    auto add = [&hash](void const *data, size_t size) {
+        for (size_t i = 0; i < size; i++) {
+            hash = (hash ^ reinterpret_cast< uint8_t const * >(data)[i]) * 0x100000001b3ull;
+        }
+    };
+    add(&player_at, sizeof(player_at));
+    add(lit_rows.data(), sizeof(lit_rows));
+    return hash;
+}
+
+void PlayMode::update_ppu() {
+    //--- set ppu state based on game state ---
+
+    //player sprite (interpolated between the last two updates, so it moves smoothly at any frame rate):
+    glm::vec2 player_drawn = player_was + (player_at - player_was) * interpolation_alpha;
+    ppu.sprites[32].x = int8_t(player_drawn.x);
+    ppu.sprites[32].y = int8_t(player_drawn.y);
+}
@@ -1,5 +1,6 @@
 #include "PPU466.hpp"
 #include "Mode.hpp"
+#include "AssetWatcher.hpp"
 
 #include <glm/glm.hpp>
 
@@ -15,6 +16,16 @@ struct PlayMode : Mode {
 	virtual bool handle_event(SDL_Event const &, glm::uvec2 const &window_size) override;
 	virtual void update(float elapsed) override;
 	virtual void draw(glm::uvec2 const &drawable_size) override;
+	virtual bool snapshot(PPU466 *ppu) override;
+
+	//set ppu state based on game state (done by draw; call directly to render on the CPU instead, e.g. with ppu.render_indexed):
+	void update_ppu();
+
+	//checksum of the game state (so replays of recorded input can check they ended up where the recording did):
+	uint64_t state_checksum() const;
+
+	//does this key change the game state? (only these are recorded and replayed -- not, e.g., F12, which saves a frame to disk)
+	static bool is_game_key(SDL_Keycode key);
 
     /* used to index into the palette table with more human-readable values */
     enum PaletteTableIndex : size_t {
@@ -35,17 +46,35 @@ struct PlayMode : Mode {
 
 	//player position:
 	glm::vec2 player_at = glm::vec2(0.0f);
+	glm::vec2 player_was = glm::vec2(0.0f); //...as of the previous update (drawn between the two, see Mode::interpolation_alpha)
 
-    // background quadrant info and function to update palette:
-    std::array< std::string, 4 > magic_values = {"Q_LL", "Q_LR", "Q_UL", "Q_UR"};
-    std::array< std::vector< char >, 4 > quadrant_chunks;
-    std::size_t quadrant_height = PPU466::BackgroundHeight / 4;
-    std::size_t quadrant_width = PPU466::BackgroundWidth / 4;
-    std::array< size_t, 4 > start_idxs;
+    // maze layout, stored as one bitmask per background row (bit j of row i is set if tile (j, i) is a wall)
+    //  so neighbors of a whole row can be found with a few shifts and ANDs:
+    static_assert(PPU466::BackgroundWidth == 64, "one bit per background column");
+    typedef std::array< uint64_t, PPU466::BackgroundHeight > MazeRows;
+    MazeRows maze_rows = {};
+    MazeRows lit_rows = {}; /* walls that have been illuminated */
+    /* how far (up to 'distance', signed) the box [min, max] can move along x (or y) before it would overlap a wall
+     * (just touching one is fine); only the cells it passes through are checked, so even long moves can't skip over a wall */
+    float sweep_x(glm::vec2 min, glm::vec2 max, float distance) const;
+    float sweep_y(glm::vec2 min, glm::vec2 max, float distance) const;
 
-    void draw_quadrant(uint8_t quadrant);
+    // background quadrant info and functions to update tiles + palettes:
+    static constexpr std::size_t QuadrantHeight = PPU466::BackgroundHeight / 4;
+    static constexpr std::size_t QuadrantWidth = PPU466::BackgroundWidth / 4;
+
+    void draw_maze(std::size_t row_begin, std::size_t row_end);
     void illuminate_quadrant(uint8_t quadrant);
 
+    // palette + tile tables are loaded from dist/assets (by loading functions, see Load.hpp) and reloaded whenever
+    //  the asset watcher sees a file rewritten (e.g., by re-running the build); only entries that changed are patched:
+    AssetWatcher asset_watcher;
+    /* checks for (and applies) rewritten assets -- once per frame, from draw() or snapshot(), since checking takes a system call
+     * and reloading is about what's shown, not part of the simulation that update() steps */
+    void reload_changed_assets();
+    size_t set_palette_table(decltype(PPU466::palette_table) const &palette_table); /* returns the number of palettes that changed */
+    size_t set_tile_table(decltype(PPU466::tile_table) const &tile_table); /* returns the number of tiles that changed */
+
 	//----- drawing handled by PPU466 -----
 	PPU466 ppu;
 };
@@ -0,0 +1,58 @@
+#pragma once
+
+/*
+ * A TripleBuffer hands copies of a T from one thread (the writer) to another (the reader) without locks or waiting:
+ *
+ * //writer -- fill in back(), then publish it:
+ * buffer.back() = state;
+ * buffer.publish();
+ *
+ * //reader -- pick up the most recently published T (if there's a new one) and use it:
+ * buffer.acquire();
+ * use(buffer.front());
+ *
+ * Of the three buffers, the writer owns one ('back'), the reader owns one ('front'),
+ *  and the third ('middle') holds the most recently published T until one side swaps it for theirs.
+ * So the writer never waits for the reader to finish with a T, and the reader always sees the newest complete one
+ *  (any published in between are skipped).
+ */
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+template< typename T >
+struct TripleBuffer {
+	//all three buffers start as copies of 'initial', so the reader has something to use before anything is published:
+	explicit TripleBuffer(T const &initial = T()) : buffers{{ initial, initial, initial }} { }
+
+	//----- writer -----
+	T &back() { return buffers[back_index]; }
+	//make back() the newest T, and get a new back() to fill in (contents unspecified):
+	void publish() {
+		back_index = middle.exchange(uint8_t(back_index | Fresh), std::memory_order_acq_rel) & IndexMask;
+	}
+
+	//----- reader -----
+	//swap in the newest T as front(), if one has been published since the last call; returns whether one had:
+	bool acquire() {
+		if (!(middle.load(std::memory_order_relaxed) & Fresh)) return false;
+		//(only the writer changes 'middle' in the meantime, and it always leaves it Fresh)
+		front_index = middle.exchange(front_index, std::memory_order_acq_rel) & IndexMask;
+		return true;
+	}
+	T const &front() const { return buffers[front_index]; }
+
+	TripleBuffer(TripleBuffer const &) = delete;
+	TripleBuffer &operator=(TripleBuffer const &) = delete;
+
+private:
+	enum : uint8_t {
+		IndexMask = 0x3,
+		Fresh = 0x4, //set in 'middle' when it holds a T the reader hasn't acquired yet
+	};
+	std::array< T, 3 > buffers;
+	uint8_t back_index = 0; //(only used by the writer)
+	uint8_t front_index = 1; //(only used by the reader)
+	std::atomic< uint8_t > middle{2};
+};
@@ -1,10 +1,13 @@
 #include <array>
+#include <cctype>
+#include <cstring>
 #include <fstream>
 #include <vector>
+#include <stdexcept>
 
-#include "data_path.hpp"
+#include "asset_pipeline.hpp"
 #include "load_save_png.hpp"
-#include "read_write_chunk.hpp"
+#include "ChunkBundle.hpp"
 #include "PPU466.hpp"
 
 uint8_t get_index_in_palette(PPU466::Palette &palette, glm::u8vec4 color) {
@@ -79,40 +82,166 @@ std::vector< PPU466::Tile > generate_tiles_from_spritesheet(std::vector<glm::u8v
     return ret_vector;
 }
 
-void generate_level_layout_binary() {
-    std::ofstream output_binary(data_path("assets/level-layout.bin"), std::ios::binary);
+std::array< uint8_t, 256 > remap_png_palette(std::vector< glm::u8vec4 > const &png_palette, PPU466::Palette const &palette) {
+    std::array< uint8_t, 256 > remap;
+    remap.fill(4);
+    for (size_t i = 0; i < png_palette.size() && i < remap.size(); i++) {
+        PPU466::Palette palette_copy = palette;
+        remap[i] = get_index_in_palette(palette_copy, png_palette[i]);
+    }
+    return remap;
+}
 
-    /* Read in the level layout png */
-    std::vector< glm::u8vec4 > level_layout_data;
-    glm::uvec2 level_layout_size;
-    load_png(data_path("assets/level-layout.png"), &level_layout_size, &level_layout_data, LowerLeftOrigin);
-    assert(level_layout_size == glm::uvec2(32, 30));
+std::vector< PPU466::Tile > generate_tiles_from_indexed_spritesheet(std::vector< uint8_t > const &spritesheet_indices,
+                                                                    glm::uvec2 const &spritesheet_size,
+                                                                    std::array< uint8_t, 256 > const &remap) {
+    assert(spritesheet_size.x % 8 == 0 && spritesheet_size.y % 8 == 0);
+    assert(spritesheet_indices.size() == size_t(spritesheet_size.x) * spritesheet_size.y);
+    size_t rows = spritesheet_size.y / 8;
+    size_t cols = spritesheet_size.x / 8;
 
-    /* splitting data vector into 4 quadrants */
-    std::array<std::string, 4> magic_values = {"Q_LL", "Q_LR", "Q_UL", "Q_UR"};
+    std::vector< PPU466::Tile > ret_vector;
+    ret_vector.reserve(rows * cols);
 
-    size_t quadrant_height = level_layout_size.y / 2;
-    size_t quadrant_width = level_layout_size.x / 2;
+    for (size_t r = rows; r > 0; r--) { /* current tile row in spritesheet, considering lower left (same order as generate_tiles_from_spritesheet) */
+        for (size_t c = 0; c < cols; c++) { /* current tile col in spritesheet */
+            PPU466::Tile tile = {};
+            for (size_t i = 0; i < 8; i++) { /* row within the tile */
+                uint8_t const *row = &spritesheet_indices[((r - 1) * 8 + i) * spritesheet_size.x + c * 8];
+                uint8_t bit0_row = 0;
+                uint8_t bit1_row = 0;
+                for (size_t j = 0; j < 8; j++) {
+                    uint8_t color_index = remap[row[j]];
+                    assert(color_index < 4);
+                    bit0_row |= (color_index & 1) << j;
+                    bit1_row |= (color_index >> 1) << j;
+                }
+                tile.bit0[i] = bit0_row;
+                tile.bit1[i] = bit1_row;
+            }
+            ret_vector.push_back(tile);
+        }
+    }
+
+    return ret_vector;
+}
 
-    for (uint8_t r = 0; r < 2; r++) { /* lower and upper quadrants */
-        for (uint8_t c = 0; c < 2; c++) { /* left and right quadrants */
-            std::vector< char > current_quadrant_data;
-            size_t start_idx = (r * quadrant_height * level_layout_size.x) + (c * quadrant_width);
+std::array< PPU466::Palette, 8 > generate_palette_table_from_data(std::vector< glm::u8vec4 > const &palette_table_data,
+                                                                 glm::uvec2 const &palette_table_size) {
+    if (palette_table_size != glm::uvec2(4, 8)) {
+        throw std::runtime_error("Palette table png should be 4x8 (one palette per row).");
+    }
 
-            /* reading a quadrant into current_quadrant_data */
-            for (size_t i = 0; i < quadrant_height; i++) { /* current row of data */
-                for (size_t j = 0; j < quadrant_width; j++) { /* current column of data */
-                    size_t cur_pixel = start_idx + (i * level_layout_size.x) + j;
+    std::array< PPU466::Palette, 8 > palette_table = {};
+    for (size_t i = 0; i < 8; i++) { /* looping over each palette in table */
+        for (size_t j = 0; j < 4; j++) { /* looping over each color in palette */
+            palette_table[i][j] = palette_table_data[(4 * i) + j];
+        }
+    }
+    return palette_table;
+}
 
-                    /* true if the corresponding pixel is black and false otherwise */
-                    current_quadrant_data.push_back(level_layout_data[cur_pixel] == glm::u8vec4(0u) ? '0' : '1');
-                }
+std::vector< uint8_t > const &TilePacker::add(std::string const &name, std::vector< PPU466::Tile > const &group_tiles, uint8_t palette_index) {
+    /* group names become constants in the generated header */
+    bool identifier = !name.empty() && !std::isdigit(uint8_t(name[0]));
+    for (char c : name) identifier = identifier && (std::isalnum(uint8_t(c)) || c == '_');
+    if (!identifier) {
+        throw std::runtime_error("Tile group name '" + name + "' isn't a valid C++ identifier.");
+    }
+    for (auto const &group : groups) {
+        if (group.first == name) throw std::runtime_error("Tile group '" + name + "' was added twice.");
+    }
+
+    std::vector< uint8_t > slots;
+    slots.reserve(group_tiles.size());
+
+    for (PPU466::Tile const &tile : group_tiles) {
+        /* hash the two bitplanes (plus the palette, unless tiles are merged across palettes) */
+        uint64_t bit0, bit1;
+        std::memcpy(&bit0, tile.bit0.data(), sizeof(bit0));
+        std::memcpy(&bit1, tile.bit1.data(), sizeof(bit1));
+        uint64_t hash = bit0 * 0x9e3779b97f4a7c15ull ^ (bit1 + 0x632be59bd9b4e019ull + (bit0 << 6) + (bit0 >> 2));
+        if (!merge_across_palettes) hash ^= uint64_t(palette_index) * 0xbf58476d1ce4e5b9ull;
+
+        /* look for an identical tile that's already been packed */
+        int32_t slot = -1;
+        auto range = slots_by_hash.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            PPU466::Tile const &packed = tiles[it->second];
+            if (packed.bit0 == tile.bit0 && packed.bit1 == tile.bit1
+             && (merge_across_palettes || tile_palettes[it->second] == palette_index)) {
+                slot = it->second;
+                break;
             }
-            assert(current_quadrant_data.size() == quadrant_height * quadrant_width);
+        }
 
-            uint8_t q_idx = (r << 1) | c;
-            write_chunk(magic_values[q_idx], current_quadrant_data, &output_binary);
+        if (slot < 0) {
+            if (tiles.size() >= 256) {
+                throw std::runtime_error("Ran out of tile table slots while packing '" + name + "' (all 256 are in use).");
+            }
+            slot = int32_t(tiles.size());
+            tiles.push_back(tile);
+            tile_palettes.push_back(palette_index);
+            slots_by_hash.emplace(hash, uint8_t(slot));
         }
+        slots.push_back(uint8_t(slot));
     }
+
+    tiles_added += group_tiles.size();
+    groups.emplace_back(name, std::move(slots));
+    return groups.back().second;
 }
 
+void TilePacker::write_header(std::string const &filename) const {
+    std::ofstream header(filename, std::ios::binary);
+    header << "#pragma once\n\n"
+           << "/* Tile table slots assigned by TilePacker (see asset_pipeline.hpp) when baking the tile sheets.\n"
+           << " * This file is generated by the bake-tiles tool (run by Maekfile.js); edit the sheets or Maekfile.js instead. */\n\n"
+           << "#include <cstdint>\n\n"
+           << "namespace TileSlots {\n";
+    for (auto const &group : groups) {
+        std::string const &name = group.first;
+        std::vector< uint8_t > const &slots = group.second;
+        if (slots.size() == 1) {
+            header << "    constexpr uint8_t " << name << " = " << int(slots[0]) << ";\n";
+        } else {
+            header << "    constexpr uint8_t " << name << "[" << slots.size() << "] = {";
+            for (size_t i = 0; i < slots.size(); i++) {
+                header << (i ? ", " : " ") << int(slots[i]);
+            }
+            header << " };\n";
+        }
+    }
+    header << "    constexpr uint32_t Count = " << tiles.size() << "; /* slots used (of 256), from " << tiles_added << " tiles */\n"
+           << "}\n";
+
+    if (!header) {
+        throw std::runtime_error("Failed to write tile slot header '" + filename + "'.");
+    }
+}
+
+void generate_level_layout_binary(std::string const &png_filename, std::string const &binary_filename) {
+    /* packing each row of the layout into a bitmask, one bit per background column */
+    std::vector< uint64_t > maze_rows(PPU466::BackgroundHeight, 0);
+
+    /* stream the level layout png a row at a time, so only the packed masks are ever held in memory */
+    glm::uvec2 level_layout_size;
+    load_png_rows(png_filename, &level_layout_size, LowerLeftOrigin, [&](uint32_t i, glm::u8vec4 const *row) {
+        if (level_layout_size.x > PPU466::BackgroundWidth || level_layout_size.y > PPU466::BackgroundHeight) {
+            throw std::runtime_error("Level layout '" + png_filename + "' is larger than the background.");
+        }
+        for (size_t j = 0; j < level_layout_size.x; j++) { /* current column of data */
+            /* wall if the corresponding pixel is black and ground if it is transparent */
+            if (row[j] != glm::u8vec4(0u)) maze_rows[i] |= uint64_t(1) << j;
+        }
+    });
+
+    ChunkBundleWriter bundle;
+    bundle.add(fourcc("MAZE"), maze_rows);
+
+    std::ofstream output_binary(binary_filename, std::ios::binary);
+    bundle.write(&output_binary);
+    if (!output_binary) {
+        throw std::runtime_error("Failed to write level layout binary '" + binary_filename + "'.");
+    }
+}
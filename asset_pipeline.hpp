@@ -1,6 +1,11 @@
 #pragma once
 #include "PPU466.hpp"
 
+#include <array>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
 /*
  * Asset Pipeline - Nellie Tonev
  *
@@ -36,11 +41,75 @@ std::vector< PPU466::Tile > generate_tiles_from_spritesheet(std::vector<glm::u8v
                                                             PPU466::Palette palette);
 
 /*
- * This function is run as part of the authoring process, not during runtime.
+ * Given the palette of a paletted png (from load_png_indexed) and a PPU palette, returns a table mapping each png
+ * palette index to the PPU palette index with the same color. This way colors are matched once per palette entry
+ * instead of once per pixel. png palette entries whose color isn't in the PPU palette map to 4 (out of range).
+ */
+std::array< uint8_t, 256 > remap_png_palette(std::vector< glm::u8vec4 > const &png_palette, PPU466::Palette const &palette);
+
+/*
+ * Same as generate_tiles_from_spritesheet, but for palette indices (typically from load_png_indexed): each index is
+ * passed through the remap table (see remap_png_palette) and written straight into the tile bitplanes.
+ * A single 8x8 image gives a single tile.
+ * For accurate results, have indices loaded with LowerLeftOrigin.
+ *
+ * REQUIRES: The width and height of the spritesheet must both be divisible by 8, and every index used in the
+ *          spritesheet must be remapped to a valid PPU palette index (< 4).
+ */
+std::vector< PPU466::Tile > generate_tiles_from_indexed_spritesheet(std::vector< uint8_t > const &spritesheet_indices,
+                                                                    glm::uvec2 const &spritesheet_size,
+                                                                    std::array< uint8_t, 256 > const &remap);
+
+/*
+ * Given pixel color data from the palette table reference png (4 colors wide, one palette per row, loaded with
+ * UpperLeftOrigin), returns the corresponding PPU palette table.
+ *
+ * REQUIRES: the size of the png is 4x8 (throws otherwise)
+ */
+std::array< PPU466::Palette, 8 > generate_palette_table_from_data(std::vector< glm::u8vec4 > const &palette_table_data,
+                                                                 glm::uvec2 const &palette_table_size);
+
+/*
+ * Packs tiles from any number of spritesheets into the PPU's 256-slot tile table, at bake time.
+ * Each tile is hashed on its bitplanes, and a tile identical to one already packed reuses that slot instead of
+ * taking a new one. By default, identical tiles only share a slot if they were also drawn for the same palette;
+ * with merge_across_palettes, identical bitplanes always share a slot (the PPU picks the palette per background
+ * cell / sprite anyway, so this is safe whenever nothing needs to edit the tiles of one palette independently).
+ * Slots are handed out in the order tiles are first added, so adding sheets in a fixed order gives stable slots.
+ *
+ * The packed tiles end up in `tiles` (slot i is tiles[i]), and the slot of every added tile in `groups`, which
+ * write_header turns into named constexpr indices for the game to use in place of hard-coded slots.
+ */
+struct TilePacker {
+    explicit TilePacker(bool merge_across_palettes = false) : merge_across_palettes(merge_across_palettes) { }
+
+    /* adds a named group of tiles (typically one spritesheet), drawn for palette table entry palette_index,
+     * and returns the slot assigned to each one. Throws if the tile table runs out of slots.
+     * (name is used as a C++ identifier in the generated header, so add also throws if it isn't one) */
+    std::vector< uint8_t > const &add(std::string const &name, std::vector< PPU466::Tile > const &group_tiles, uint8_t palette_index);
+
+    /* writes a header with one constexpr slot index (or array of indices, for multi-tile groups) per group.
+     * Throws if the file can't be written. */
+    void write_header(std::string const &filename) const;
+
+    bool merge_across_palettes;
+
+    std::vector< PPU466::Tile > tiles; /* packed tile table contents */
+    std::vector< uint8_t > tile_palettes; /* palette each packed tile was first added with */
+    std::vector< std::pair< std::string, std::vector< uint8_t > > > groups; /* name -> slots, in the order added */
+    size_t tiles_added = 0; /* before deduplication */
+
+private:
+    std::unordered_multimap< uint64_t, uint8_t > slots_by_hash;
+};
+
+/*
+ * This function is run as part of the authoring process, not during runtime
+ * (by the bake-level-layout tool, which Maekfile.js runs whenever assets/level-layout.png changes).
  *
  * Takes a level layout png image (transparent png with black pixels corresponding to a tile on the background)
- * and then processes it into 4 chunks of chars (for 4 quadrants of the background, which are relevant to the geme mechanic of illuminating
- * the maze, quadrants at a time). In the chunks, '1' indicates there is a maze wall at that location on screen, while
- * '0' means there is just ground. Chunks are stored in `dist/assets/level-layout.bin`
+ * and then packs each row of it into a 64-bit mask (one bit per background column, set where there is a maze wall).
+ * The masks for all background rows are stored as the MAZE chunk of binary_filename (`dist/assets/level-layout.bin`),
+ * a ChunkBundle (see ChunkBundle.hpp). At runtime, whole rows of the maze can then be autotiled and lit with shifts and ANDs.
  */
-void generate_level_layout_binary();
\ No newline at end of file
+void generate_level_layout_binary(std::string const &png_filename, std::string const &binary_filename);
\ No newline at end of file
@@ -0,0 +1,22 @@
+//Bakes a level layout png into the binary that PlayMode reads at runtime.
+// usage: bake-level-layout <level-layout.png> <level-layout.bin>
+// (run automatically by Maekfile.js when the png changes)
+
+#include "asset_pipeline.hpp"
+
+#include <iostream>
+#include <stdexcept>
+
+int main(int argc, char **argv) {
+	if (argc != 3) {
+		std::cerr << "Usage:\n\t" << argv[0] << " <level-layout.png> <level-layout.bin>" << std::endl;
+		return 1;
+	}
+	try {
+		generate_level_layout_binary(argv[1], argv[2]);
+	} catch (std::exception const &e) {
+		std::cerr << "Failed to bake level layout: " << e.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
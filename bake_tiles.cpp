@@ -0,0 +1,83 @@
+//Packs the tile sheets into the tile table that PlayMode loads at runtime, along with a header naming each tile's slot.
+// usage: bake-tiles [--merge-across-palettes] <palette_table.png> <tiles.bin> <tile_slots.hpp> <Name>:<palette>:<sheet.png> [...]
+//  each sheet is sliced into 8x8 tiles, colored with palette table entry <palette>, and given slots named TileSlots::<Name>
+// (run automatically by Maekfile.js when any of the sheets change)
+
+#include "asset_pipeline.hpp"
+#include "load_save_png.hpp"
+#include "ChunkBundle.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+int main(int argc, char **argv) {
+	std::vector< std::string > args(argv + 1, argv + argc);
+	bool merge_across_palettes = false;
+	if (!args.empty() && args[0] == "--merge-across-palettes") {
+		merge_across_palettes = true;
+		args.erase(args.begin());
+	}
+	if (args.size() < 4) {
+		std::cerr << "Usage:\n\t" << argv[0] << " [--merge-across-palettes] <palette_table.png> <tiles.bin> <tile_slots.hpp> <Name>:<palette>:<sheet.png> [...]" << std::endl;
+		return 1;
+	}
+
+	try {
+		//sheets are named Name:palette:file.png (split on the first two colons, so file names may contain more):
+		struct Sheet {
+			std::string name;
+			uint8_t palette;
+		};
+		std::vector< Sheet > sheets;
+		std::vector< PNGLoad > pngs;
+		pngs.emplace_back(args[0], UpperLeftOrigin);
+		for (size_t i = 3; i < args.size(); ++i) {
+			size_t colon0 = args[i].find(':');
+			size_t colon1 = (colon0 == std::string::npos ? colon0 : args[i].find(':', colon0 + 1));
+			if (colon1 == std::string::npos) {
+				throw std::runtime_error("Expected <Name>:<palette>:<sheet.png>, got '" + args[i] + "'.");
+			}
+			int palette = std::stoi(args[i].substr(colon0 + 1, colon1 - colon0 - 1));
+			if (palette < 0 || palette >= 8) {
+				throw std::runtime_error("Palette index in '" + args[i] + "' should be in [0,8).");
+			}
+			sheets.emplace_back(Sheet{args[i].substr(0, colon0), uint8_t(palette)});
+			pngs.emplace_back(args[i].substr(colon1 + 1), LowerLeftOrigin);
+			pngs.back().prefer_indexed = true; //tiles can be built straight from palette indices
+		}
+		load_pngs(&pngs);
+
+		std::array< PPU466::Palette, 8 > palette_table = generate_palette_table_from_data(pngs[0].data, pngs[0].size);
+
+		TilePacker packer(merge_across_palettes);
+		for (size_t i = 0; i < sheets.size(); ++i) {
+			PNGLoad &png = pngs[i + 1];
+			if (png.size.x % 8 != 0 || png.size.y % 8 != 0) {
+				throw std::runtime_error("Sheet '" + png.filename + "' isn't a whole number of 8x8 tiles.");
+			}
+			PPU466::Palette const &palette = palette_table[sheets[i].palette];
+			//paletted pngs go straight to bitplanes; others are matched by color:
+			std::vector< PPU466::Tile > tiles = (!png.indices.empty()
+				? generate_tiles_from_indexed_spritesheet(png.indices, png.size, remap_png_palette(png.palette, palette))
+				: generate_tiles_from_spritesheet(png.data, png.size, palette));
+			packer.add(sheets[i].name, tiles, sheets[i].palette);
+		}
+
+		ChunkBundleWriter bundle;
+		bundle.add(fourcc("TILE"), packer.tiles);
+		std::ofstream output(args[1], std::ios::binary);
+		bundle.write(&output);
+		if (!output) {
+			throw std::runtime_error("Failed to write tile table '" + args[1] + "'.");
+		}
+
+		packer.write_header(args[2]);
+
+		std::cout << "Packed " << packer.tiles_added << " tiles into " << packer.tiles.size() << " of 256 slots." << std::endl;
+	} catch (std::exception const &e) {
+		std::cerr << "Failed to bake tiles: " << e.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
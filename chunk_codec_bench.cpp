@@ -0,0 +1,75 @@
+//Measures decode throughput of each chunk codec.
+// usage: chunk-codec-bench [file1 file2 ...]
+// (with no files, benchmarks a synthetic sparse map the size of the full PPU466 background, repeated)
+
+#include "chunk_codecs.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <cstdlib>
+
+static std::vector< uint8_t > synthetic_map() {
+	//64x60 cells of '0'/'1', mostly ground with long walls, repeated 64 times:
+	std::vector< uint8_t > map;
+	uint32_t seed = 0x466;
+	for (uint32_t copy = 0; copy < 64; ++copy) {
+		for (uint32_t y = 0; y < 60; ++y) {
+			for (uint32_t x = 0; x < 64; ++x) {
+				seed = seed * 1664525u + 1013904223u;
+				bool wall = (y % 6 == 0 && (seed >> 28) != 0) || (x % 8 == 0 && (seed >> 29) == 0);
+				map.emplace_back(wall ? '1' : '0');
+			}
+		}
+	}
+	return map;
+}
+
+static void bench(std::string const &name, std::vector< uint8_t > const &data) {
+	std::cout << name << " (" << data.size() << " bytes):\n";
+	std::vector< uint8_t > decoded(data.size());
+	for (uint32_t c = 0; c < MaxChunkCodec; ++c) {
+		ChunkCodec codec = ChunkCodec(c);
+		std::vector< uint8_t > compressed = compress_chunk(codec, data.data(), data.size());
+
+		//repeat decoding until enough time has passed to get a stable measurement:
+		uint32_t iterations = 0;
+		auto before = std::chrono::high_resolution_clock::now();
+		float seconds = 0.0f;
+		do {
+			decompress_chunk(codec, compressed.data(), compressed.size(), decoded.data(), decoded.size());
+			++iterations;
+			seconds = std::chrono::duration< float >(std::chrono::high_resolution_clock::now() - before).count();
+		} while (seconds < 0.25f);
+
+		if (decoded != data) {
+			std::cerr << "ERROR: " << chunk_codec_name(codec) << " did not round-trip." << std::endl;
+			std::exit(1);
+		}
+
+		std::cout << "  " << std::setw(5) << chunk_codec_name(codec)
+		          << "  ratio " << std::fixed << std::setprecision(3) << float(compressed.size()) / float(std::max< size_t >(1, data.size()))
+		          << "  decode " << std::setprecision(1) << (double(data.size()) * iterations / seconds) / (1024.0 * 1024.0) << " MiB/s"
+		          << std::endl;
+	}
+}
+
+int main(int argc, char **argv) {
+	if (argc <= 1) {
+		bench("synthetic map", synthetic_map());
+	}
+	for (int i = 1; i < argc; ++i) {
+		std::ifstream file(argv[i], std::ios::binary);
+		if (!file) {
+			std::cerr << "Failed to open '" << argv[i] << "'." << std::endl;
+			return 1;
+		}
+		std::vector< uint8_t > data((std::istreambuf_iterator< char >(file)), std::istreambuf_iterator< char >());
+		bench(argv[i], data);
+	}
+	return 0;
+}
@@ -0,0 +1,239 @@
+#include "chunk_codecs.hpp"
+
+#include <stdexcept>
+#include <cstring>
+#include <cassert>
+#include <array>
+#include <algorithm>
+
+char const *chunk_codec_name(ChunkCodec codec) {
+	if (codec == ChunkCodecNone) return "none";
+	else if (codec == ChunkCodecRLE) return "rle";
+	else if (codec == ChunkCodecLZ) return "lz";
+	else return "unknown";
+}
+
+//-------------------------------------------------------------------
+//RLE:
+// control byte c < 128: copy the next c+1 bytes literally
+// control byte c >= 128: repeat the next byte (c - 128 + MinRun) times
+
+namespace {
+	constexpr size_t MinRun = 3;
+	constexpr size_t MaxRun = 127 + MinRun;
+	constexpr size_t MaxLiterals = 128;
+}
+
+static std::vector< uint8_t > compress_rle(uint8_t const *from, size_t from_size) {
+	std::vector< uint8_t > out;
+	out.reserve(from_size + from_size / MaxLiterals + 1);
+
+	size_t literal_begin = 0;
+	auto flush_literals = [&](size_t end) {
+		while (literal_begin < end) {
+			size_t count = std::min(end - literal_begin, MaxLiterals);
+			out.emplace_back(uint8_t(count - 1));
+			out.insert(out.end(), from + literal_begin, from + literal_begin + count);
+			literal_begin += count;
+		}
+	};
+
+	size_t i = 0;
+	while (i < from_size) {
+		size_t run = 1;
+		while (i + run < from_size && run < MaxRun && from[i + run] == from[i]) ++run;
+		if (run >= MinRun) {
+			flush_literals(i);
+			out.emplace_back(uint8_t(128 + run - MinRun));
+			out.emplace_back(from[i]);
+			i += run;
+			literal_begin = i;
+		} else {
+			i += run;
+		}
+	}
+	flush_literals(from_size);
+
+	return out;
+}
+
+static void decompress_rle(uint8_t const *from, size_t from_size, uint8_t *to, size_t to_size) {
+	uint8_t const *ip = from, *ip_end = from + from_size;
+	uint8_t *op = to, *op_end = to + to_size;
+	while (ip < ip_end) {
+		uint8_t c = *ip++;
+		if (c < 128) {
+			size_t count = size_t(c) + 1;
+			if (size_t(ip_end - ip) < count || size_t(op_end - op) < count) {
+				throw std::runtime_error("Corrupt RLE chunk data (literal run overflows).");
+			}
+			std::memcpy(op, ip, count);
+			ip += count;
+			op += count;
+		} else {
+			size_t count = size_t(c) - 128 + MinRun;
+			if (ip == ip_end || size_t(op_end - op) < count) {
+				throw std::runtime_error("Corrupt RLE chunk data (repeat run overflows).");
+			}
+			std::memset(op, *ip++, count);
+			op += count;
+		}
+	}
+	if (op != op_end) {
+		throw std::runtime_error("Corrupt RLE chunk data (too short).");
+	}
+}
+
+//-------------------------------------------------------------------
+//LZ:
+// sequence of [token][extra literal length][literals][offset][extra match length]
+//  token high nibble: literal count (15 => more in following bytes, each 255 means "keep going")
+//  token low nibble: match length - MinMatch (15 => more in following bytes)
+//  offset: 16-bit little-endian distance back from the current output position
+// the final sequence has literals only (stream ends right after them)
+
+namespace {
+	constexpr size_t MinMatch = 4;
+	constexpr size_t MaxOffset = 0xffff;
+	constexpr uint32_t HashBits = 12;
+}
+
+static std::vector< uint8_t > compress_lz(uint8_t const *from, size_t from_size) {
+	std::vector< uint8_t > out;
+	out.reserve(from_size + from_size / 255 + 16);
+
+	auto put_length = [&out](size_t extra) {
+		while (extra >= 255) {
+			out.emplace_back(uint8_t(255));
+			extra -= 255;
+		}
+		out.emplace_back(uint8_t(extra));
+	};
+
+	auto emit = [&](size_t literal_begin, size_t literal_end, size_t offset, size_t match_length) {
+		size_t literals = literal_end - literal_begin;
+		uint8_t token = uint8_t(std::min< size_t >(literals, 15) << 4);
+		if (match_length) token |= uint8_t(std::min< size_t >(match_length - MinMatch, 15));
+		out.emplace_back(token);
+		if (literals >= 15) put_length(literals - 15);
+		out.insert(out.end(), from + literal_begin, from + literal_end);
+		if (match_length) {
+			out.emplace_back(uint8_t(offset & 0xff));
+			out.emplace_back(uint8_t(offset >> 8));
+			if (match_length - MinMatch >= 15) put_length(match_length - MinMatch - 15);
+		}
+	};
+
+	auto read32 = [from](size_t at) {
+		uint32_t v;
+		std::memcpy(&v, from + at, 4);
+		return v;
+	};
+	auto hash = [](uint32_t v) {
+		return (v * 2654435761U) >> (32 - HashBits);
+	};
+
+	//most recent position (+1, so zero means 'none') with each hash of four bytes:
+	std::array< uint32_t, 1 << HashBits > table;
+	table.fill(0);
+
+	size_t literal_begin = 0;
+	size_t i = 0;
+	while (i + MinMatch <= from_size) {
+		uint32_t v = read32(i);
+		uint32_t &slot = table[hash(v)];
+		size_t candidate = slot;
+		slot = uint32_t(i + 1);
+		if (candidate == 0 || i - (candidate - 1) > MaxOffset || read32(candidate - 1) != v) {
+			++i;
+			continue;
+		}
+		candidate -= 1;
+
+		size_t length = MinMatch;
+		while (i + length < from_size && from[candidate + length] == from[i + length]) ++length;
+
+		emit(literal_begin, i, i - candidate, length);
+		i += length;
+		literal_begin = i;
+	}
+	emit(literal_begin, from_size, 0, 0);
+
+	return out;
+}
+
+static void decompress_lz(uint8_t const *from, size_t from_size, uint8_t *to, size_t to_size) {
+	uint8_t const *ip = from, *ip_end = from + from_size;
+	uint8_t *op = to, *op_end = to + to_size;
+
+	auto get_length = [&ip, ip_end](size_t length) {
+		uint8_t b;
+		do {
+			if (ip == ip_end) throw std::runtime_error("Corrupt LZ chunk data (truncated length).");
+			b = *ip++;
+			length += b;
+		} while (b == 255);
+		return length;
+	};
+
+	while (true) {
+		if (ip == ip_end) throw std::runtime_error("Corrupt LZ chunk data (missing token).");
+		uint8_t token = *ip++;
+
+		size_t literals = token >> 4;
+		if (literals == 15) literals = get_length(literals);
+		if (size_t(ip_end - ip) < literals || size_t(op_end - op) < literals) {
+			throw std::runtime_error("Corrupt LZ chunk data (literals overflow).");
+		}
+		if (literals) std::memcpy(op, ip, literals);
+		ip += literals;
+		op += literals;
+
+		if (ip == ip_end) break; //last sequence has no match
+
+		if (ip_end - ip < 2) throw std::runtime_error("Corrupt LZ chunk data (truncated offset).");
+		size_t offset = size_t(ip[0]) | size_t(ip[1]) << 8;
+		ip += 2;
+		size_t length = token & 0xf;
+		if (length == 15) length = get_length(length);
+		length += MinMatch;
+
+		if (offset == 0 || offset > size_t(op - to) || size_t(op_end - op) < length) {
+			throw std::runtime_error("Corrupt LZ chunk data (bad match).");
+		}
+		uint8_t const *match = op - offset;
+		if (offset >= length) {
+			std::memcpy(op, match, length);
+			op += length;
+		} else {
+			//overlapping match repeats the last 'offset' bytes:
+			for (size_t i = 0; i < length; ++i) *op++ = *match++;
+		}
+	}
+
+	if (op != op_end) {
+		throw std::runtime_error("Corrupt LZ chunk data (too short).");
+	}
+}
+
+//-------------------------------------------------------------------
+
+std::vector< uint8_t > compress_chunk(ChunkCodec codec, uint8_t const *from, size_t from_size) {
+	if (codec == ChunkCodecNone) return std::vector< uint8_t >(from, from + from_size);
+	else if (codec == ChunkCodecRLE) return compress_rle(from, from_size);
+	else if (codec == ChunkCodecLZ) return compress_lz(from, from_size);
+	else throw std::runtime_error("Unknown chunk codec.");
+}
+
+void decompress_chunk(ChunkCodec codec, uint8_t const *from, size_t from_size, uint8_t *to, size_t to_size) {
+	if (codec == ChunkCodecNone) {
+		if (from_size != to_size) throw std::runtime_error("Uncompressed chunk has unexpected size.");
+		if (to_size) std::memcpy(to, from, to_size);
+	} else if (codec == ChunkCodecRLE) {
+		decompress_rle(from, from_size, to, to_size);
+	} else if (codec == ChunkCodecLZ) {
+		decompress_lz(from, from_size, to, to_size);
+	} else {
+		throw std::runtime_error("Unknown chunk codec.");
+	}
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+/*
+ * Compression codecs for chunk data (used by ChunkBundle).
+ *
+ * ChunkCodecRLE is a PackBits-style run-length code; it does well on sparse map data.
+ * ChunkCodecLZ is an LZ4-style block format (literal runs + back-references into a 64k window);
+ *  it does well on more general repetitive data, like tile sheets.
+ *
+ * Decompression writes directly into a caller-provided buffer of the (known) uncompressed size,
+ *  so no intermediate allocation is needed.
+ */
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+enum ChunkCodec : uint8_t {
+	ChunkCodecNone = 0,
+	ChunkCodecRLE = 1,
+	ChunkCodecLZ = 2,
+	MaxChunkCodec //<-- just used to track # of codecs
+};
+
+//name of codec, for printing:
+char const *chunk_codec_name(ChunkCodec codec);
+
+//compress 'size' bytes from 'from' with 'codec':
+std::vector< uint8_t > compress_chunk(ChunkCodec codec, uint8_t const *from, size_t from_size);
+
+//decompress exactly 'to_size' bytes into 'to':
+// (throws if the compressed data is corrupt or doesn't decode to exactly to_size bytes)
+void decompress_chunk(ChunkCodec codec, uint8_t const *from, size_t from_size, uint8_t *to, size_t to_size);
@@ -0,0 +1,74 @@
+#include "frame_pacing.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <thread>
+
+FramePacer::FramePacer(float refresh_rate) {
+	//(some drivers report a refresh rate of 0 when they don't know it)
+	if (!(refresh_rate > 0.0f)) refresh_rate = 60.0f;
+	period = std::chrono::duration_cast< Clock::duration >(std::chrono::duration< float >(1.0f / refresh_rate));
+}
+
+void FramePacer::wait() {
+	if (has_presented) {
+		//next vblank after now, assuming they continue every 'period' from the last present:
+		Clock::time_point now = Clock::now();
+		Clock::time_point vblank = last_present + period;
+		while (vblank <= now) vblank += period;
+
+		Clock::duration expected_work = *std::max_element(work.begin(), work.end());
+		Clock::time_point start = vblank - expected_work - margin;
+		//(if there isn't enough time before that vblank, the frame would be shown at the one after anyway -- so aim for that)
+		while (start < now) start += period;
+		std::this_thread::sleep_until(start);
+	}
+	frame_start = Clock::now();
+}
+
+void FramePacer::submitted() {
+	work[next_work] = Clock::now() - frame_start;
+	next_work = (next_work + 1) % work.size();
+}
+
+void FramePacer::presented() {
+	last_present = Clock::now();
+	has_presented = true;
+}
+
+void LatencyHistogram::add(uint32_t ms) {
+	buckets[std::min< size_t >(ms, buckets.size() - 1)] += 1;
+	count += 1;
+	total_ms += ms;
+	max_ms = std::max(max_ms, ms);
+}
+
+void LatencyHistogram::report(std::ostream &to) const {
+	if (count == 0) {
+		to << "Input-to-present latency: no input events." << std::endl;
+		return;
+	}
+	//smallest bucket with at least 'fraction' of events at or below it:
+	auto percentile = [this](double fraction) {
+		uint32_t needed = uint32_t(std::max(1.0, fraction * count + 0.5));
+		uint32_t seen = 0;
+		for (size_t b = 0; b < buckets.size(); ++b) {
+			seen += buckets[b];
+			if (seen >= needed) return uint32_t(b);
+		}
+		return uint32_t(buckets.size() - 1);
+	};
+	to << "Input-to-present latency (" << count << " events): mean " << total_ms / count << " ms, "
+	   << "p50 " << percentile(0.5) << " ms, p95 " << percentile(0.95) << " ms, p99 " << percentile(0.99) << " ms, "
+	   << "max " << max_ms << " ms\n";
+
+	uint32_t largest = *std::max_element(buckets.begin(), buckets.end());
+	for (size_t b = 0; b < buckets.size(); ++b) {
+		if (buckets[b] == 0) continue;
+		std::string label = std::to_string(b) + (b + 1 == buckets.size() ? "+" : "") + " ms";
+		to << std::string(label.size() < 8 ? 8 - label.size() : 0, ' ') << label << " | "
+		   << std::string(std::max< uint32_t >(1, buckets[b] * 50 / largest), '#') << ' ' << buckets[b] << '\n';
+	}
+	to.flush();
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+/*
+ * Frame pacing helpers for main.cpp:
+ *
+ * FramePacer implements "late latching" (main.cpp's --late-latch option):
+ *  with vsync, a frame that's started right after the previous swap can sit finished for most of a refresh
+ *  before it is shown, so the input it used is that much older than it needs to be.
+ *  Instead, the pacer sleeps until just enough time is left before the predicted vblank to poll input, update,
+ *  and draw -- so frames are shown as soon as possible after their input is read.
+ *
+ * FramePacer pacer(60.0f); //display refresh rate
+ * while (...) {
+ *     pacer.wait(); //sleep until it's time to start the frame
+ *     //...poll input, update, draw...
+ *     pacer.submitted();
+ *     SDL_GL_SwapWindow(window);
+ *     pacer.presented();
+ * }
+ *
+ * LatencyHistogram collects input-to-present latencies (from each input event's timestamp to the return of the
+ *  SDL_GL_SwapWindow that first showed its effects) and prints them as a histogram.
+ */
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+
+struct FramePacer {
+	typedef std::chrono::steady_clock Clock;
+
+	explicit FramePacer(float refresh_rate);
+
+	//sleep until the predicted vblank, less the time frames have been taking (plus 'margin'):
+	void wait();
+	//call once the frame's work is done, just before swapping:
+	void submitted();
+	//call right after swapping (with vsync, that's about when a vblank happened):
+	void presented();
+
+	Clock::duration period; //time between vblanks
+	Clock::duration margin = std::chrono::microseconds(1500); //slack left for timing jitter
+
+	//how long recent frames took from wait() returning to submitted():
+	// (the estimate of how long the next one will take is the longest of these)
+	std::array< Clock::duration, 32 > work = {};
+	uint32_t next_work = 0;
+
+	Clock::time_point frame_start;
+	Clock::time_point last_present;
+	bool has_presented = false;
+};
+
+struct LatencyHistogram {
+	//buckets are a millisecond wide; the last one also counts everything slower:
+	std::array< uint32_t, 100 > buckets = {};
+	uint32_t count = 0;
+	double total_ms = 0.0;
+	uint32_t max_ms = 0;
+
+	void add(uint32_t ms);
+
+	//print count, mean, percentiles, and a bar for every non-empty bucket:
+	void report(std::ostream &to) const;
+};
@@ -1,31 +1,37 @@
 #pragma once
 
 #include "GL.hpp"
-#include <iostream>
+#include "log.hpp"
 
 #define STR2(X) # X
 #define STR(X) STR2(X)
 
-inline void gl_errors(std::string const &where) {
-	GLenum err = 0;
-	while ((err = glGetError()) != GL_NO_ERROR) {
-		#define CHECK( ERR ) \
-			if (err == ERR) { \
-				std::cerr << "WARNING: gl error '" #ERR "' at " << where << std::endl; \
-			} else
+//name of a glGetError() code (or "unknown" for codes not listed here):
+inline char const *gl_error_name(GLenum err) {
+	#define CHECK( ERR ) \
+		if (err == ERR) { \
+			return #ERR; \
+		} else
 
-		CHECK( GL_INVALID_ENUM )
-		CHECK( GL_INVALID_VALUE )
-		CHECK( GL_INVALID_OPERATION )
-		CHECK( GL_INVALID_FRAMEBUFFER_OPERATION )
-		CHECK( GL_OUT_OF_MEMORY )
-		CHECK( GL_STACK_UNDERFLOW )
-		CHECK( GL_STACK_OVERFLOW )
-		{
-			std::cerr << "WARNING: gl error '" << err << "'" << std::endl;
-		}
-		#undef CHECK
+	CHECK( GL_INVALID_ENUM )
+	CHECK( GL_INVALID_VALUE )
+	CHECK( GL_INVALID_OPERATION )
+	CHECK( GL_INVALID_FRAMEBUFFER_OPERATION )
+	CHECK( GL_OUT_OF_MEMORY )
+	CHECK( GL_STACK_UNDERFLOW )
+	CHECK( GL_STACK_OVERFLOW )
+	{
+		return "unknown";
 	}
+	#undef CHECK
 }
-#define GL_ERRORS() gl_errors(__FILE__  ":" STR(__LINE__) )
 
+//log every pending gl error, labelled with where GL_ERRORS() was called:
+// (a macro, so each call is a separate LOG_* call site -- errors from one place don't use up another's rate limit)
+#define GL_ERRORS() \
+	do { \
+		GLenum gl_errors_err_; \
+		while ((gl_errors_err_ = glGetError()) != GL_NO_ERROR) { \
+			LOG_WARNING("gl error '{}' ({}) at {}", gl_error_name(gl_errors_err_), gl_errors_err_, __FILE__ ":" STR(__LINE__)); \
+		} \
+	} while (0)
@@ -1,4 +1,6 @@
 #include "load_save_png.hpp"
+#include "MappedFile.hpp"
+#include "log.hpp"
 
 #include <png.h>
 
@@ -6,31 +8,129 @@
 #include <fstream>
 #include <cassert>
 #include <vector>
-
-#define LOG_ERROR( X ) std::cerr << X << std::endl
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+#include <array>
 
 using std::vector;
 
 bool load_png(std::istream &from, unsigned int *width, unsigned int *height, vector< glm::u8vec4 > *data, OriginLocation origin);
+static bool load_png(png_voidp io, png_rw_ptr read_fn, unsigned int *width, unsigned int *height, vector< glm::u8vec4 > *data, OriginLocation origin, vector< png_bytep > *row_pointers);
 void save_png(std::ostream &to, unsigned int width, unsigned int height, glm::u8vec4 const *data, OriginLocation origin);
+static void save_png_indexed(std::ostream &to, unsigned int width, unsigned int height, uint8_t const *indices, std::vector< glm::u8vec4 > const &palette, OriginLocation origin, int compression_level);
 
 void load_png(std::string filename, glm::uvec2 *size, std::vector< glm::u8vec4 > *data, OriginLocation origin) {
 	assert(size);
 
-	std::ifstream file(filename.c_str(), std::ios::binary);
-	if (!file) {
+	MappedFile file;
+	try {
+		file = MappedFile(filename);
+	} catch (std::runtime_error &) {
 		throw std::runtime_error("Failed to open PNG image file '" + filename + "'.");
 	}
-	if (!load_png(file, &size->x, &size->y, data, origin)) {
+	try {
+		load_png(file.data(), file.size(), size, data, origin);
+	} catch (std::runtime_error &) {
 		throw std::runtime_error("Failed to read PNG image from '" + filename + "'.");
 	}
 }
 
+bool load_png_indexed(std::string filename, glm::uvec2 *size, std::vector< uint8_t > *indices, std::vector< glm::u8vec4 > *palette, OriginLocation origin) {
+	MappedFile file;
+	try {
+		file = MappedFile(filename);
+	} catch (std::runtime_error &) {
+		throw std::runtime_error("Failed to open PNG image file '" + filename + "'.");
+	}
+	try {
+		return load_png_indexed(file.data(), file.size(), size, indices, palette, origin);
+	} catch (std::runtime_error &) {
+		throw std::runtime_error("Failed to read PNG image from '" + filename + "'.");
+	}
+}
+
+//reads from memory by bumping a pointer:
+struct MemoryReader {
+	uint8_t const *at;
+	uint8_t const *end;
+};
+
+static void user_read_memory(png_structp png_ptr, png_bytep data, png_size_t length) {
+	MemoryReader *from = reinterpret_cast< MemoryReader * >(png_get_io_ptr(png_ptr));
+	assert(from);
+	if (size_t(from->end - from->at) < length) {
+		png_error(png_ptr, "Error reading (past end of data).");
+	}
+	std::memcpy(data, from->at, length);
+	from->at += length;
+}
+
+void load_png(uint8_t const *png_data, size_t png_size, glm::uvec2 *size, std::vector< glm::u8vec4 > *data, OriginLocation origin, std::vector< uint8_t * > *row_storage) {
+	assert(size);
+	static_assert(std::is_same< png_bytep, uint8_t * >::value, "row storage holds png_bytep");
+
+	MemoryReader reader{png_data, png_data + png_size};
+	vector< png_bytep > local_rows;
+	if (!load_png(&reader, user_read_memory, &size->x, &size->y, data, origin, row_storage ? row_storage : &local_rows)) {
+		throw std::runtime_error("Failed to read PNG image from memory.");
+	}
+}
+
 void save_png(std::string filename, glm::uvec2 size, glm::u8vec4 const *data, OriginLocation origin) {
 	std::ofstream file(filename.c_str(), std::ios::binary);
 	save_png(file, size.x, size.y, data, origin);
 }
 
+void save_png_indexed(std::string filename, glm::uvec2 size, uint8_t const *indices, std::vector< glm::u8vec4 > const &palette, OriginLocation origin, int compression_level) {
+	std::ofstream file(filename.c_str(), std::ios::binary);
+	save_png_indexed(file, size.x, size.y, indices, palette, origin, compression_level);
+}
+
+void load_pngs(std::vector< PNGLoad > *loads_, uint32_t max_threads) {
+	assert(loads_);
+	auto &loads = *loads_;
+
+	if (max_threads == 0) max_threads = std::max(1U, std::thread::hardware_concurrency());
+	uint32_t thread_count = uint32_t(std::min< size_t >(max_threads, loads.size()));
+
+	//each worker claims the next unclaimed file until none are left:
+	std::atomic< size_t > next(0);
+	std::vector< std::exception_ptr > errors(loads.size());
+	auto worker = [&]() {
+		for (size_t i = next++; i < loads.size(); i = next++) {
+			PNGLoad &load = loads[i];
+			auto before = std::chrono::high_resolution_clock::now();
+			try {
+				if (!(load.prefer_indexed && load_png_indexed(load.filename, &load.size, &load.indices, &load.palette, load.origin))) {
+					load_png(load.filename, &load.size, &load.data, load.origin);
+				}
+			} catch (...) {
+				errors[i] = std::current_exception();
+			}
+			load.decode_seconds = std::chrono::duration< float >(std::chrono::high_resolution_clock::now() - before).count();
+		}
+	};
+
+	//(the calling thread works too, rather than just waiting)
+	std::vector< std::thread > threads;
+	for (uint32_t t = 1; t < thread_count; ++t) {
+		threads.emplace_back(worker);
+	}
+	worker();
+	for (auto &thread : threads) {
+		thread.join();
+	}
+
+	for (auto const &error : errors) {
+		if (error) std::rethrow_exception(error);
+	}
+}
+
 
 static void user_read_data(png_structp png_ptr, png_bytep data, png_size_t length) {
 	std::istream *from = reinterpret_cast< std::istream * >(png_get_io_ptr(png_ptr));
@@ -57,8 +157,161 @@ static void user_flush_data(png_structp png_ptr) {
 }
 
 
+bool load_png_indexed(uint8_t const *png_data, size_t png_size, glm::uvec2 *size, std::vector< uint8_t > *indices, std::vector< glm::u8vec4 > *palette, OriginLocation origin) {
+	assert(size);
+	assert(indices);
+	assert(palette);
+	*size = glm::uvec2(0);
+	indices->clear();
+	palette->clear();
+
+	MemoryReader reader{png_data, png_data + png_size};
+	png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, (png_voidp)NULL, (png_error_ptr)NULL, (png_error_ptr)NULL);
+	if (!png) {
+		throw std::runtime_error("Cannot alloc png read struct.");
+	}
+	png_set_read_fn(png, &reader, user_read_memory);
+	png_infop info = png_create_info_struct(png);
+	if (!info) {
+		png_destroy_read_struct(&png, (png_infopp)NULL, (png_infopp)NULL);
+		throw std::runtime_error("Cannot alloc png info struct.");
+	}
+	vector< png_bytep > row_pointers;
+	if (setjmp(png_jmpbuf(png))) {
+		png_destroy_read_struct(&png, &info, (png_infopp)NULL);
+		indices->clear();
+		palette->clear();
+		throw std::runtime_error("Internal png error.");
+	}
+	png_read_info(png, info);
+	if (png_get_color_type(png, info) != PNG_COLOR_TYPE_PALETTE) {
+		png_destroy_read_struct(&png, &info, (png_infopp)NULL);
+		return false;
+	}
+	unsigned int w = png_get_image_width(png, info);
+	unsigned int h = png_get_image_height(png, info);
+
+	{ //copy out palette (+ transparency):
+		png_colorp colors = nullptr;
+		int color_count = 0;
+		png_get_PLTE(png, info, &colors, &color_count);
+		png_bytep alphas = nullptr;
+		int alpha_count = 0;
+		if (png_get_valid(png, info, PNG_INFO_tRNS)) {
+			png_get_tRNS(png, info, &alphas, &alpha_count, NULL);
+		}
+		palette->resize(color_count);
+		for (int i = 0; i < color_count; ++i) {
+			(*palette)[i] = glm::u8vec4(colors[i].red, colors[i].green, colors[i].blue, (i < alpha_count ? alphas[i] : 0xff));
+		}
+	}
+
+	//unpack 1/2/4-bit indices to one byte per pixel:
+	if (png_get_bit_depth(png, info) < 8)
+		png_set_packing(png);
+
+	png_read_update_info(png, info);
+	assert(png_get_rowbytes(png, info) == w);
+
+	indices->resize(size_t(w) * h);
+	row_pointers.resize(h);
+	for (unsigned int r = 0; r < h; ++r) {
+		if (origin == LowerLeftOrigin) {
+			row_pointers[h-1-r] = indices->data() + size_t(r) * w;
+		} else {
+			row_pointers[r] = indices->data() + size_t(r) * w;
+		}
+	}
+	png_read_image(png, row_pointers.data());
+	png_destroy_read_struct(&png, &info, NULL);
+
+	*size = glm::uvec2(w, h);
+	return true;
+}
+
+//ask libpng to convert whatever is in the file to 32-bit RGBA:
+// (call after png_read_info; calls png_read_update_info)
+static void set_rgba_transforms(png_structp png, png_infop info) {
+	if (png_get_color_type(png, info) == PNG_COLOR_TYPE_PALETTE)
+		png_set_palette_to_rgb(png);
+	if (png_get_color_type(png, info) == PNG_COLOR_TYPE_GRAY || png_get_color_type(png, info) == PNG_COLOR_TYPE_GRAY_ALPHA)
+		png_set_gray_to_rgb(png);
+	if (!(png_get_color_type(png, info) & PNG_COLOR_MASK_ALPHA))
+		png_set_add_alpha(png, 0xff, PNG_FILLER_AFTER);
+	if (png_get_bit_depth(png, info) < 8)
+		png_set_packing(png);
+	if (png_get_bit_depth(png,info) == 16)
+		png_set_strip_16(png);
+	//Ok, should be 32-bit RGBA now.
+
+	png_read_update_info(png, info);
+	size_t rowbytes = png_get_rowbytes(png, info);
+	//Make sure it's the format we think it is...
+	assert(rowbytes == png_get_image_width(png, info)*sizeof(uint32_t));
+	(void)rowbytes; //(unused in release builds)
+}
+
+void load_png_rows(std::string filename, glm::uvec2 *size, OriginLocation origin, std::function< void(uint32_t y, glm::u8vec4 const *row) > const &row_fn) {
+	assert(size);
+	*size = glm::uvec2(0);
+
+	MappedFile file;
+	try {
+		file = MappedFile(filename);
+	} catch (std::runtime_error &) {
+		throw std::runtime_error("Failed to open PNG image file '" + filename + "'.");
+	}
+	MemoryReader reader{file.data(), file.data() + file.size()};
+
+	png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, (png_voidp)NULL, (png_error_ptr)NULL, (png_error_ptr)NULL);
+	if (!png) {
+		throw std::runtime_error("Cannot alloc png read struct.");
+	}
+	png_set_read_fn(png, &reader, user_read_memory);
+	png_infop info = png_create_info_struct(png);
+	if (!info) {
+		png_destroy_read_struct(&png, (png_infopp)NULL, (png_infopp)NULL);
+		throw std::runtime_error("Cannot alloc png info struct.");
+	}
+	//the only full-width buffer is a single row:
+	vector< glm::u8vec4 > row;
+	if (setjmp(png_jmpbuf(png))) {
+		png_destroy_read_struct(&png, &info, (png_infopp)NULL);
+		throw std::runtime_error("Failed to read PNG image from '" + filename + "'.");
+	}
+	png_read_info(png, info);
+	if (png_get_interlace_type(png, info) != PNG_INTERLACE_NONE) {
+		//(interlaced rows only become final on the last pass, which defeats streaming)
+		png_destroy_read_struct(&png, &info, (png_infopp)NULL);
+		throw std::runtime_error("Can't stream rows of interlaced PNG image '" + filename + "'.");
+	}
+	unsigned int w = png_get_image_width(png, info);
+	unsigned int h = png_get_image_height(png, info);
+	set_rgba_transforms(png, info);
+
+	*size = glm::uvec2(w, h);
+	row.resize(w);
+	try {
+		for (unsigned int r = 0; r < h; ++r) {
+			png_read_row(png, reinterpret_cast< png_bytep >(row.data()), NULL);
+			//rows are stored top-to-bottom in the file:
+			row_fn(origin == LowerLeftOrigin ? h-1-r : r, row.data());
+		}
+	} catch (...) {
+		png_destroy_read_struct(&png, &info, (png_infopp)NULL);
+		throw;
+	}
+	png_destroy_read_struct(&png, &info, NULL);
+}
+
 bool load_png(std::istream &from, unsigned int *width, unsigned int *height, vector< glm::u8vec4 > *data, OriginLocation origin) {
+	vector< png_bytep > row_pointers;
+	return load_png(&from, user_read_data, width, height, data, origin, &row_pointers);
+}
+
+static bool load_png(png_voidp io, png_rw_ptr read_fn, unsigned int *width, unsigned int *height, vector< glm::u8vec4 > *data, OriginLocation origin, vector< png_bytep > *row_pointers) {
 	assert(data);
+	assert(row_pointers);
 	uint32_t local_width, local_height;
 	if (width == nullptr) width = &local_width;
 	if (height == nullptr) height = &local_height;
@@ -68,23 +321,21 @@ bool load_png(std::istream &from, unsigned int *width, unsigned int *height, vec
 	//Load a png file, as per the libpng docs:
 	png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, (png_voidp)NULL, (png_error_ptr)NULL, (png_error_ptr)NULL);
 
-	png_set_read_fn(png, &from, user_read_data);
+	png_set_read_fn(png, io, read_fn);
 
 	if (!png) {
-		LOG_ERROR("  cannot alloc read struct.");
+		LOG_ERROR("Can't create png read struct.");
 		return false;
 	}
 	png_infop info = png_create_info_struct(png);
 	if (!info) {
-		LOG_ERROR("  cannot alloc info struct.");
+		LOG_ERROR("Can't create png info struct.");
 		png_destroy_read_struct(&png, (png_infopp)NULL, (png_infopp)NULL);
 		return false;
 	}
-	png_bytep *row_pointers = NULL;
 	if (setjmp(png_jmpbuf(png))) {
-		LOG_ERROR("  png interal error.");
+		LOG_ERROR("Error reading png.");
 		png_destroy_read_struct(&png, &info, (png_infopp)NULL);
-		if (row_pointers != NULL) delete[] row_pointers;
 		data->clear();
 		return false;
 	}
@@ -92,35 +343,19 @@ bool load_png(std::istream &from, unsigned int *width, unsigned int *height, vec
 	png_read_info(png, info);
 	unsigned int w = png_get_image_width(png, info);
 	unsigned int h = png_get_image_height(png, info);
-	if (png_get_color_type(png, info) == PNG_COLOR_TYPE_PALETTE)
-		png_set_palette_to_rgb(png);
-	if (png_get_color_type(png, info) == PNG_COLOR_TYPE_GRAY || png_get_color_type(png, info) == PNG_COLOR_TYPE_GRAY_ALPHA)
-		png_set_gray_to_rgb(png);
-	if (!(png_get_color_type(png, info) & PNG_COLOR_MASK_ALPHA))
-		png_set_add_alpha(png, 0xff, PNG_FILLER_AFTER);
-	if (png_get_bit_depth(png, info) < 8)
-		png_set_packing(png);
-	if (png_get_bit_depth(png,info) == 16)
-		png_set_strip_16(png);
-	//Ok, should be 32-bit RGBA now.
-
-	png_read_update_info(png, info);
-	size_t rowbytes = png_get_rowbytes(png, info);
-	//Make sure it's the format we think it is...
-	assert(rowbytes == w*sizeof(uint32_t));
+	set_rgba_transforms(png, info);
 
 	data->resize(w*h);
-	row_pointers = new png_bytep[h];
+	row_pointers->resize(h);
 	for (unsigned int r = 0; r < h; ++r) {
 		if (origin == LowerLeftOrigin) {
-			row_pointers[h-1-r] = (png_bytep)(&(*data)[r*w]);
+			(*row_pointers)[h-1-r] = (png_bytep)(&(*data)[r*w]);
 		} else {
-			row_pointers[r] = (png_bytep)(&(*data)[r*w]);
+			(*row_pointers)[r] = (png_bytep)(&(*data)[r*w]);
 		}
 	}
-	png_read_image(png, row_pointers);
+	png_read_image(png, row_pointers->data());
 	png_destroy_read_struct(&png, &info, NULL);
-	delete[] row_pointers;
 
 	*width = w;
 	*height = h;
@@ -142,7 +377,7 @@ void save_png(std::ostream &to, unsigned int width, unsigned int height, glm::u8
 	png_infop info_ptr = png_create_info_struct(png_ptr);
 	if (info_ptr == NULL) {
 		png_destroy_write_struct(&png_ptr, NULL);
-		LOG_ERROR("Can't craete info pointer");
+		LOG_ERROR("Can't create info pointer");
 		return;
 	}
 
@@ -173,3 +408,68 @@ void save_png(std::ostream &to, unsigned int width, unsigned int height, glm::u8
 
 	return;
 }
+
+static void save_png_indexed(std::ostream &to, unsigned int width, unsigned int height, uint8_t const *indices, std::vector< glm::u8vec4 > const &palette, OriginLocation origin, int compression_level) {
+	if (palette.empty() || palette.size() > PNG_MAX_PALETTE_LENGTH) {
+		LOG_ERROR("Can't save png with a palette of {} colors.", palette.size());
+		return;
+	}
+
+	png_structp png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+
+	if (png_ptr == NULL) {
+		LOG_ERROR("Can't create write struct.");
+		return;
+	}
+
+	png_set_write_fn(png_ptr, &to, user_write_data, user_flush_data);
+
+	png_infop info_ptr = png_create_info_struct(png_ptr);
+	if (info_ptr == NULL) {
+		png_destroy_write_struct(&png_ptr, NULL);
+		LOG_ERROR("Can't create info pointer");
+		return;
+	}
+
+	if (setjmp(png_jmpbuf(png_ptr))) {
+		png_destroy_write_struct(&png_ptr, &info_ptr);
+		LOG_ERROR("Error writing png.");
+		return;
+	}
+
+	png_set_IHDR(png_ptr, info_ptr, width, height, 8, PNG_COLOR_TYPE_PALETTE, PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE);
+
+	std::array< png_color, PNG_MAX_PALETTE_LENGTH > colors;
+	std::array< png_byte, PNG_MAX_PALETTE_LENGTH > alphas;
+	bool all_opaque = true;
+	for (size_t i = 0; i < palette.size(); ++i) {
+		colors[i].red = palette[i].r;
+		colors[i].green = palette[i].g;
+		colors[i].blue = palette[i].b;
+		alphas[i] = palette[i].a;
+		if (palette[i].a != 0xff) all_opaque = false;
+	}
+	png_set_PLTE(png_ptr, info_ptr, colors.data(), int(palette.size()));
+	if (!all_opaque) {
+		png_set_tRNS(png_ptr, info_ptr, alphas.data(), int(palette.size()), NULL);
+	}
+
+	//filtering rarely helps paletted images, and skipping it is faster:
+	png_set_filter(png_ptr, PNG_FILTER_TYPE_BASE, PNG_FILTER_NONE);
+	png_set_compression_level(png_ptr, compression_level);
+
+	png_write_info(png_ptr, info_ptr);
+	vector< png_bytep > row_pointers(height);
+	for (unsigned int i = 0; i < height; ++i) {
+		if (origin == UpperLeftOrigin) {
+			row_pointers[i] = (png_bytep)&(indices[i * width]);
+		} else {
+			row_pointers[i] = (png_bytep)&(indices[(height - 1 - i) * width]);
+		}
+	}
+	png_write_image(png_ptr, row_pointers.data());
+
+	png_write_end(png_ptr, info_ptr);
+
+	png_destroy_write_struct(&png_ptr, &info_ptr);
+}
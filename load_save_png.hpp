@@ -4,6 +4,7 @@
 
 #include <string>
 #include <vector>
+#include <functional>
 #include <stdint.h>
 
 /*
@@ -18,3 +19,45 @@ enum OriginLocation {
 //NOTE: load_png will throw on error
 void load_png(std::string filename, glm::uvec2 *size, std::vector< glm::u8vec4 > *data, OriginLocation origin);
 void save_png(std::string filename, glm::uvec2 size, glm::u8vec4 const *data, OriginLocation origin);
+
+//save an 8-bit paletted image (palette has at most 256 entries; alpha is stored in a tRNS chunk if not all opaque):
+// compression_level is a zlib level (0-9); the default favors speed, since paletted images are small anyway
+void save_png_indexed(std::string filename, glm::uvec2 size, uint8_t const *indices, std::vector< glm::u8vec4 > const &palette, OriginLocation origin, int compression_level = 1);
+
+//load from a block of memory (e.g., a MappedFile or a chunk in a ChunkBundle) without going through a stream:
+// row_storage, if given, is used (and resized as needed) for libpng's row pointer array,
+//  so callers loading many images can avoid allocating one each time.
+void load_png(uint8_t const *png_data, size_t png_size, glm::uvec2 *size, std::vector< glm::u8vec4 > *data, OriginLocation origin, std::vector< uint8_t * > *row_storage = nullptr);
+
+//load one row at a time, without ever holding the whole image in memory:
+// row_fn is called once per row, with the row's y coordinate (relative to origin) and its size.x pixels
+// rows are delivered in file order: top-to-bottom (so, with LowerLeftOrigin, y counts down from size.y-1)
+// size is set before the first call to row_fn
+//NOTE: load_png_rows will throw on error (including for interlaced images); exceptions from row_fn are passed through
+void load_png_rows(std::string filename, glm::uvec2 *size, OriginLocation origin, std::function< void(uint32_t y, glm::u8vec4 const *row) > const &row_fn);
+
+//load a paletted (PNG_COLOR_TYPE_PALETTE, bit depth 1-8) image without expanding it to RGBA:
+// indices gets one palette index per pixel; palette gets the PNG's own palette (alpha from its tRNS chunk, if any)
+//returns false if the image isn't paletted (so the caller can fall back to load_png); throws on other errors
+bool load_png_indexed(std::string filename, glm::uvec2 *size, std::vector< uint8_t > *indices, std::vector< glm::u8vec4 > *palette, OriginLocation origin);
+bool load_png_indexed(uint8_t const *png_data, size_t png_size, glm::uvec2 *size, std::vector< uint8_t > *indices, std::vector< glm::u8vec4 > *palette, OriginLocation origin);
+
+//Batch loading: decode several files concurrently on worker threads,
+// so loading costs about as much as the largest image instead of the sum of all of them.
+struct PNGLoad {
+	PNGLoad(std::string const &filename_, OriginLocation origin_) : filename(filename_), origin(origin_) { }
+	std::string filename;
+	OriginLocation origin;
+	bool prefer_indexed = false; //if set, paletted images are loaded with load_png_indexed
+
+	//filled in by load_pngs:
+	glm::uvec2 size = glm::uvec2(0);
+	std::vector< glm::u8vec4 > data; //RGBA pixels (empty if loaded as indices)
+	std::vector< uint8_t > indices; //palette indices (only if prefer_indexed and image was paletted)
+	std::vector< glm::u8vec4 > palette; //palette for indices
+	float decode_seconds = 0.0f; //wall time spent loading this file
+};
+
+//NOTE: load_pngs waits for every load to finish, then throws the first error (if any)
+// max_threads = 0 means "use one thread per hardware thread"
+void load_pngs(std::vector< PNGLoad > *loads, uint32_t max_threads = 0);
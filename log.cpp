@@ -0,0 +1,256 @@
+#include "log.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//Each thread that logs gets a ring of records that only it writes and only the flush thread reads.
+//Rings are never freed: when a thread exits, its ring is marked free and the next new thread to log takes it over
+// (after any records still in it, so nothing is lost) -- so threads can find and register rings without locks.
+struct LogRing {
+	static constexpr uint32_t Capacity = 512;
+	std::array< LogRecord, Capacity > records;
+	std::atomic< uint32_t > head{0}; //next record the owning thread will write
+	std::atomic< uint32_t > tail{0}; //next record the flush thread will read
+	std::atomic< uint32_t > dropped{0}; //records lost because the ring was full
+	std::atomic< bool > in_use{true}; //is some thread writing to this ring?
+	LogRing *next = nullptr; //(set before the ring is added to the list, never changed after)
+};
+
+namespace {
+
+std::atomic< LogRing * > rings{nullptr};
+std::atomic< bool > shut_down{false};
+
+//the calling thread's ring:
+struct RingOwner {
+	LogRing *ring = nullptr;
+	~RingOwner() {
+		if (ring) ring->in_use.store(false, std::memory_order_release);
+	}
+};
+thread_local RingOwner owner;
+
+LogRing *this_thread_ring() {
+	if (owner.ring) return owner.ring;
+	//take over the ring of an exited thread, if there is one:
+	for (LogRing *ring = rings.load(std::memory_order_acquire); ring; ring = ring->next) {
+		if (!ring->in_use.load(std::memory_order_relaxed) && !ring->in_use.exchange(true, std::memory_order_acquire)) {
+			owner.ring = ring;
+			return ring;
+		}
+	}
+	//otherwise add a new one (once per thread, so the allocation is fine):
+	LogRing *ring = new LogRing;
+	ring->next = rings.load(std::memory_order_relaxed);
+	while (!rings.compare_exchange_weak(ring->next, ring, std::memory_order_release, std::memory_order_relaxed)) { }
+	owner.ring = ring;
+	return ring;
+}
+
+void format(LogRecord const &record, std::string *out_) {
+	std::string &out = *out_;
+	if (record.level == LogLevel::Warning) out += "WARNING: ";
+	else if (record.level == LogLevel::Error) out += "ERROR: ";
+
+	uint32_t arg = 0;
+	for (char const *c = record.format; *c; ++c) {
+		if (c[0] == '{' && c[1] == '}' && arg < record.arg_count) {
+			LogRecord::Value const &value = record.values[arg];
+			switch (record.types[arg]) {
+				case LogRecord::Signed: out += std::to_string(value.s); break;
+				case LogRecord::Unsigned: out += std::to_string(value.u); break;
+				case LogRecord::Float: {
+					char buffer[32];
+					std::snprintf(buffer, sizeof(buffer), "%g", value.f);
+					out += buffer;
+					break;
+				}
+				case LogRecord::String: out += record.text + value.text; break;
+			}
+			arg += 1;
+			++c;
+		} else {
+			out += *c;
+		}
+	}
+	if (record.suppressed) {
+		out += " (" + std::to_string(record.suppressed) + " more from here were suppressed)";
+	}
+	out += '\n';
+}
+
+//std::terminate handler that was installed before the logger's:
+std::terminate_handler previous_terminate = nullptr;
+
+struct Logger;
+Logger &logger();
+
+struct Logger {
+	Logger() : thread([this](){ run(); }) {
+		//an uncaught exception ends the program without destroying the logger, so print what's been logged first
+		// (messages logged just before a failure are often the ones that explain it):
+		previous_terminate = std::set_terminate([](){
+			//(unless it's the flush thread itself failing -- it may be holding the lock log_flush needs)
+			if (std::this_thread::get_id() != logger().thread.get_id()) log_flush();
+			if (previous_terminate) previous_terminate();
+			std::abort();
+		});
+	}
+	~Logger() {
+		{
+			std::unique_lock< std::mutex > lock(mutex);
+			quit = true;
+		}
+		wake.notify_one();
+		thread.join();
+		shut_down.store(true, std::memory_order_relaxed);
+	}
+
+	//print everything committed to any ring so far (only one caller at a time; hold 'mutex'):
+	void drain() {
+		struct Line {
+			uint64_t time;
+			bool error; //(goes to std::cerr)
+			std::string text;
+		};
+		std::vector< Line > lines;
+		uint32_t dropped = 0;
+		for (LogRing *ring = rings.load(std::memory_order_acquire); ring; ring = ring->next) {
+			uint32_t tail = ring->tail.load(std::memory_order_relaxed);
+			uint32_t head = ring->head.load(std::memory_order_acquire);
+			for (; tail != head; ++tail) {
+				LogRecord const &record = ring->records[tail % LogRing::Capacity];
+				lines.emplace_back();
+				lines.back().time = record.time;
+				lines.back().error = (record.level >= LogLevel::Warning);
+				format(record, &lines.back().text);
+			}
+			ring->tail.store(tail, std::memory_order_seq_cst); //(seq_cst: see log_commit)
+			dropped += ring->dropped.exchange(0, std::memory_order_relaxed);
+		}
+
+		//(threads' messages are interleaved by time, so they read in the order they were logged)
+		std::stable_sort(lines.begin(), lines.end(), [](Line const &a, Line const &b) { return a.time < b.time; });
+		for (Line const &line : lines) {
+			(line.error ? std::cerr : std::cout) << line.text;
+		}
+		if (dropped) {
+			std::cerr << "WARNING: " << dropped << " log messages were dropped because a thread's log buffer was full.\n";
+		}
+		if (!lines.empty() || dropped) {
+			std::cout.flush();
+			std::cerr.flush();
+		}
+	}
+
+	//is there anything in any ring that hasn't been printed yet?
+	bool anything_to_drain() {
+		for (LogRing *ring = rings.load(std::memory_order_acquire); ring; ring = ring->next) {
+			if (ring->head.load(std::memory_order_seq_cst) != ring->tail.load(std::memory_order_relaxed)) return true; //(seq_cst: see log_commit)
+		}
+		return false;
+	}
+
+	void run() {
+		std::unique_lock< std::mutex > lock(mutex);
+		while (!quit) {
+			//sleep until log_commit puts a record in an empty ring
+			// (log_commit notifies without taking the lock -- so logging never waits -- which means a notify that lands just
+			//  before this thread starts waiting is missed; the timeout bounds how late that leaves a message)
+			wake.wait_for(lock, std::chrono::seconds(1), [this](){ return quit || anything_to_drain(); });
+			drain();
+		}
+		drain();
+	}
+
+	std::mutex mutex;
+	std::condition_variable wake;
+	bool quit = false;
+	std::thread thread; //(declared last so it starts once everything it uses exists)
+};
+
+Logger &logger() {
+	static Logger logger;
+	return logger;
+}
+
+} //end of anonymous namespace
+
+uint64_t log_now() {
+	return uint64_t(std::chrono::duration_cast< std::chrono::nanoseconds >(
+		std::chrono::steady_clock::now().time_since_epoch()
+	).count());
+}
+
+LogRecord *log_begin(LogSite &site, char const *format) {
+	uint64_t now = log_now();
+
+	//rate limit: count messages in a one second window from the first one after the previous window ended
+	// (the window reset can race with other threads' messages, so the limit is approximate -- that's fine)
+	uint64_t start = site.window_start.load(std::memory_order_relaxed);
+	if (start == 0 || now - start >= 1000000000ull) {
+		if (site.window_start.compare_exchange_strong(start, now, std::memory_order_relaxed)) {
+			site.in_window.store(0, std::memory_order_relaxed);
+		}
+	}
+	if (site.in_window.fetch_add(1, std::memory_order_relaxed) >= LOG_RATE_LIMIT) {
+		site.suppressed.fetch_add(1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	if (shut_down.load(std::memory_order_relaxed)) return nullptr;
+	logger(); //(starts the flush thread on first use)
+
+	LogRing *ring = this_thread_ring();
+	uint32_t head = ring->head.load(std::memory_order_relaxed);
+	if (head - ring->tail.load(std::memory_order_acquire) >= LogRing::Capacity) {
+		ring->dropped.fetch_add(1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	LogRecord &record = ring->records[head % LogRing::Capacity];
+	record.format = format;
+	record.time = now;
+	record.suppressed = site.suppressed.exchange(0, std::memory_order_relaxed);
+	record.level = site.level;
+	record.arg_count = 0;
+	record.text_used = 0;
+	return &record;
+}
+
+void log_commit() {
+	LogRing *ring = owner.ring;
+	uint32_t head = ring->head.load(std::memory_order_relaxed);
+	//wake the flush thread only if it had printed everything before this record -- once per burst of messages, not per message
+	// (otherwise it's awake, and will see this record in Logger::anything_to_drain before it sleeps: with these seq_cst, either
+	//  that check sees the new head, or this sees the tail the flush thread stored before checking)
+	ring->head.store(head + 1, std::memory_order_seq_cst);
+	if (ring->tail.load(std::memory_order_seq_cst) == head) logger().wake.notify_one();
+}
+
+void LogRecord::add(char const *str, size_t length) {
+	if (arg_count == MaxArgs || text_used == TextSize) return;
+	length = std::min< size_t >(length, TextSize - 1 - text_used);
+	std::memcpy(text + text_used, str, length);
+	text[text_used + length] = '\0';
+	types[arg_count] = String;
+	values[arg_count].text = text_used;
+	text_used = uint8_t(text_used + length + 1);
+	arg_count += 1;
+}
+
+void log_flush() {
+	if (shut_down.load(std::memory_order_relaxed)) return;
+	Logger &l = logger();
+	std::unique_lock< std::mutex > lock(l.mutex);
+	l.drain();
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+/*
+ * Asynchronous logging, cheap enough to use on the per-frame path:
+ *
+ * LOG_INFO("Reloaded '{}' in {} ms.", name, ms);
+ * LOG_WARNING("gl error '{}' at {}", "GL_INVALID_ENUM", where);
+ *
+ * Each '{}' in the format is replaced by the next argument (integers, floating point numbers, and strings).
+ * The format itself must be a string literal -- only a pointer to it is kept until the message is printed.
+ *
+ * Logging a message doesn't format or print anything: it copies the arguments into a ring buffer owned by the
+ *  calling thread (no locks, no allocation, no waiting) and a background thread formats and prints them.
+ * Info and debug messages go to std::cout; warnings and errors go to std::cerr.
+ * If a thread's ring is full, its messages are dropped (and counted) rather than blocking.
+ *
+ * Each call site prints at most LOG_RATE_LIMIT messages per second; past that, messages are counted and the
+ *  count is printed with the next one that gets through.
+ *
+ * Messages below LOG_LEVEL (set at compile time; info by default) compile to nothing -- not even their arguments
+ *  are evaluated.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+enum class LogLevel : uint8_t {
+	Debug = 0,
+	Info = 1,
+	Warning = 2,
+	Error = 3,
+};
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL 1 //LogLevel::Info
+#endif
+
+#ifndef LOG_RATE_LIMIT
+#define LOG_RATE_LIMIT 20 //messages per second per call site
+#endif
+
+#define LOG_DEBUG(...) LOG_AT(LogLevel::Debug, __VA_ARGS__)
+#define LOG_INFO(...) LOG_AT(LogLevel::Info, __VA_ARGS__)
+#define LOG_WARNING(...) LOG_AT(LogLevel::Warning, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT(LogLevel::Error, __VA_ARGS__)
+
+#define LOG_AT(LEVEL, ...) \
+	do { \
+		if constexpr (uint8_t(LEVEL) >= LOG_LEVEL) { \
+			static LogSite log_site_(LEVEL); \
+			log_write(log_site_, __VA_ARGS__); \
+		} \
+	} while (0)
+
+//rate limiting state for one LOG_* call site:
+struct LogSite {
+	explicit LogSite(LogLevel level_) : level(level_) { }
+	LogLevel const level;
+	std::atomic< uint64_t > window_start{0}; //(nanoseconds, on the same clock as LogRecord::time)
+	std::atomic< uint32_t > in_window{0}; //messages attempted since window_start
+	std::atomic< uint32_t > suppressed{0}; //messages dropped since the last one that got through
+};
+
+//one logged message, as stored in a ring buffer:
+struct LogRecord {
+	enum Type : uint8_t { Signed, Unsigned, Float, String };
+	static constexpr uint32_t MaxArgs = 6;
+	static constexpr uint32_t TextSize = 160; //space for copies of string arguments (longer strings are truncated)
+
+	char const *format = nullptr;
+	uint64_t time = 0;
+	uint32_t suppressed = 0;
+	LogLevel level = LogLevel::Info;
+	uint8_t arg_count = 0;
+	uint8_t text_used = 0;
+	Type types[MaxArgs];
+	union Value {
+		int64_t s;
+		uint64_t u;
+		double f;
+		uint8_t text; //offset of a (null-terminated) string in 'text'
+	} values[MaxArgs];
+	char text[TextSize];
+
+	void add(char const *str, size_t length);
+	void add(char const *str) { add(str, std::strlen(str)); }
+	void add(std::string const &str) { add(str.data(), str.size()); }
+	template< typename T >
+	void add(T value) {
+		static_assert(std::is_arithmetic< T >::value, "LOG_* arguments are numbers or strings");
+		if (arg_count == MaxArgs) return;
+		if constexpr (std::is_floating_point< T >::value) {
+			types[arg_count] = Float;
+			values[arg_count].f = double(value);
+		} else if constexpr (std::is_signed< T >::value) {
+			types[arg_count] = Signed;
+			values[arg_count].s = int64_t(value);
+		} else {
+			types[arg_count] = Unsigned;
+			values[arg_count].u = uint64_t(value);
+		}
+		arg_count += 1;
+	}
+};
+
+//current time for LogSite/LogRecord, in nanoseconds:
+uint64_t log_now();
+
+//if 'site' is within its rate limit, get a record to fill in from the calling thread's ring (otherwise nullptr):
+LogRecord *log_begin(LogSite &site, char const *format);
+//hand a record from log_begin off to be printed:
+void log_commit();
+
+template< typename... Args >
+void log_write(LogSite &site, char const *format, Args const &... args) {
+	LogRecord *record = log_begin(site, format);
+	if (!record) return;
+	(record->add(args), ...);
+	log_commit();
+}
+
+//block until every message logged so far has been printed (e.g., before exiting because of an error):
+void log_flush();
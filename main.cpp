@@ -4,6 +4,9 @@
 //The 'PlayMode' mode plays the game:
 #include "PlayMode.hpp"
 
+//The 'LoadingMode' mode shows progress while assets load:
+#include "LoadingMode.hpp"
+
 //For asset loading:
 #include "Load.hpp"
 
@@ -13,6 +16,21 @@
 //for screenshots:
 #include "load_save_png.hpp"
 
+//for timing startup:
+#include "startup_timing.hpp"
+
+//for recording and replaying input:
+#include "InputRecording.hpp"
+
+//for late latching and measuring input latency:
+#include "frame_pacing.hpp"
+
+//for handing PPU state from the simulation thread to the main thread:
+#include "TripleBuffer.hpp"
+
+//for (asynchronous) log messages:
+#include "log.hpp"
+
 //Includes for libSDL:
 #include <SDL.h>
 
@@ -22,6 +40,256 @@
 #include <stdexcept>
 #include <memory>
 #include <algorithm>
+#include <cassert>
+#include <vector>
+#include <cmath>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+
+//the simulation runs in fixed steps of Mode::Timestep:
+// (shared by the windowed and headless loops, so replays are stepped exactly as they were recorded)
+struct FixedSteps {
+	//if frames fall behind by more than this many steps, the extra time is dropped
+	// (so the game slows down instead of spending ever longer catching up):
+	uint32_t max_catch_up_steps = 12;
+
+	float unsimulated = 0.0f; //time (in seconds) that hasn't been simulated yet
+
+	//call the current mode's "update" function once for every whole step of time, and return how many steps that was:
+	// (stops early if the mode changes, so a new mode starts stepping on the next frame)
+	uint32_t advance(float elapsed) {
+		unsimulated += elapsed;
+		Mode *mode = Mode::current.get();
+		uint32_t steps = 0;
+		while (unsimulated >= Mode::Timestep && steps < max_catch_up_steps && Mode::current.get() == mode) {
+			Mode::current->update(Mode::Timestep);
+			unsimulated -= Mode::Timestep;
+			steps += 1;
+		}
+
+		//if frames are taking a very long time to process,
+		//lag to avoid spiral of death:
+		if (steps == max_catch_up_steps) unsimulated = std::fmod(unsimulated, Mode::Timestep);
+
+		//the next frame is drawn 'unsimulated' seconds after the last update, so the mode can interpolate to that point:
+		if (Mode::current) Mode::current->interpolation_alpha = std::min(1.0f, unsimulated / Mode::Timestep);
+		return steps;
+	}
+};
+
+//recording input to a file (--record) or replaying it from one (--replay); see InputRecording.hpp:
+struct Session {
+	std::string record_to; //if not empty, input is recorded and saved here
+	InputRecording recording;
+	std::unique_ptr< InputRecording > replay; //if set, input comes from here instead of the keyboard
+
+	std::shared_ptr< PlayMode > play; //the mode being recorded or replayed, once the session has started
+	uint32_t frame = 0; //frames since the session started
+
+	bool wanted() const { return !record_to.empty() || replay; }
+
+	//is this an event to record (or, from a replay, to pass on)? only keys that change the game state are
+	// -- so replays don't repeat things like saving frames to disk (see PlayMode::is_game_key):
+	static bool replayable(SDL_Event const &evt) {
+		return (evt.type == SDL_KEYDOWN || evt.type == SDL_KEYUP) && PlayMode::is_game_key(evt.key.keysym.sym);
+	}
+
+	//once the session is over, save the recording and/or check that the replay ended up where its recording did:
+	void finish() {
+		if (!play) return;
+		uint64_t checksum = play->state_checksum();
+		if (replay) {
+			if (checksum == replay->checksum) {
+				std::cout << "Replayed " << frame << " frames; the game ended in the same state as the recording." << std::endl;
+			} else {
+				std::cerr << "WARNING: replayed " << frame << " frames, but the game ended in a different state than the recording"
+				          << " (checksum " << checksum << " vs. " << replay->checksum << ")." << std::endl;
+			}
+		}
+		if (!record_to.empty()) {
+			recording.checksum = checksum;
+			recording.save(record_to);
+			std::cout << "Saved " << recording.elapsed.size() << " frames (" << recording.keys.size() << " key events) of input to '" << record_to << "'." << std::endl;
+		}
+	}
+};
+
+//--pipelined: updates the current mode on a thread of its own, so the main thread can draw one frame while the next is simulated
+// (events and elapsed time are passed over every frame; what to draw comes back as PPU466 snapshots, through a TripleBuffer)
+//Only the simulation thread uses Mode::current until 'finished' is set (once the mode changes -- e.g., to quit).
+struct SimulationThread {
+	//starts simulating Mode::current, which drew 'first' (see Mode::snapshot):
+	SimulationThread(FixedSteps &steps_, PPU466 const &first) : steps(steps_), frames(Snapshot{ first, 0 }), mode(Mode::current) {
+		thread = std::thread(&SimulationThread::run, this);
+	}
+	//(stops the thread once it has simulated every frame posted so far -- so, e.g., a recording's state at the end
+	// includes every frame it has an elapsed time for -- unless the mode changes first)
+	~SimulationThread() {
+		{
+			std::lock_guard< std::mutex > lock(mutex);
+			stop = true;
+		}
+		posted.notify_one();
+		thread.join();
+	}
+
+	//called by the main thread once per frame, with the frame's events and elapsed time:
+	void post(std::vector< SDL_Event > const &events, float elapsed, glm::uvec2 const &window_size) {
+		{
+			std::lock_guard< std::mutex > lock(mutex);
+			inbox.emplace_back(Frame{ events, elapsed, window_size });
+		}
+		posted.notify_one();
+		posted_frames += 1;
+	}
+
+	//has everything posted been simulated (and so is the newest frame in 'frames' up to date)?
+	bool caught_up() const { return simulated_frames.load(std::memory_order_acquire) == posted_frames; }
+
+	FixedSteps &steps;
+	struct Snapshot {
+		PPU466 ppu;
+		uint64_t frames; //how many posted frames had been simulated when it was taken
+	};
+	TripleBuffer< Snapshot > frames; //most recently simulated frame
+	std::shared_ptr< Mode > mode; //the mode being simulated
+	std::atomic< bool > finished{false}; //stopped because Mode::current changed (or an exception was thrown)
+	std::exception_ptr error; //exception thrown by the mode, if any (only read once 'finished')
+	uint64_t posted_frames = 0; //(only used by the main thread)
+	std::atomic< uint64_t > simulated_frames{0}; //posted frames that have been simulated and published
+
+	struct Frame {
+		std::vector< SDL_Event > events;
+		float elapsed;
+		glm::uvec2 window_size;
+	};
+	std::mutex mutex;
+	std::condition_variable posted;
+	std::vector< Frame > inbox; //frames posted but not yet simulated
+	bool stop = false;
+	std::thread thread;
+
+	void run() {
+		std::vector< Frame > work;
+		try {
+			while (true) {
+				bool stopping;
+				{
+					std::unique_lock< std::mutex > lock(mutex);
+					posted.wait(lock, [this](){ return !inbox.empty() || stop; });
+					std::swap(work, inbox);
+					inbox.clear();
+					stopping = stop;
+				}
+				//(if the main thread got ahead, catch up -- frame by frame, so it steps just as it would have on one thread -- and only snapshot the last)
+				for (Frame const &frame : work) {
+					for (SDL_Event const &evt : frame.events) {
+						mode->handle_event(evt, frame.window_size);
+					}
+					steps.advance(frame.elapsed);
+					if (Mode::current != mode) {
+						finished = true;
+						return;
+					}
+				}
+				if (stopping) return; //(no one will draw a snapshot now)
+				uint64_t simulated = simulated_frames.load(std::memory_order_relaxed) + work.size();
+				mode->snapshot(&frames.back().ppu);
+				frames.back().frames = simulated;
+				frames.publish();
+				simulated_frames.store(simulated, std::memory_order_release);
+			}
+		} catch (...) {
+			error = std::current_exception();
+			finished = true;
+		}
+	}
+};
+
+//scripted input for --headless runs: the bee tries each direction in turn (pressing 'E' whenever it changes direction),
+// which is enough to exercise movement, collision, and lighting without anyone at the keyboard:
+static void headless_input(uint32_t frame, std::vector< SDL_Event > *events_) {
+	assert(events_);
+	auto &events = *events_;
+	constexpr uint32_t FramesPerDirection = 240;
+	static SDL_Keycode const Directions[] = { SDLK_RIGHT, SDLK_UP, SDLK_LEFT, SDLK_DOWN };
+
+	auto key = [&events](Uint32 type, SDL_Keycode sym) {
+		SDL_Event evt{};
+		evt.type = type;
+		evt.key.type = type;
+		evt.key.state = (type == SDL_KEYDOWN ? SDL_PRESSED : SDL_RELEASED);
+		evt.key.keysym.sym = sym;
+		events.emplace_back(evt);
+	};
+
+	if (frame % FramesPerDirection != 0) return;
+	uint32_t direction = (frame / FramesPerDirection) % 4;
+	if (frame != 0) {
+		key(SDL_KEYUP, Directions[(direction + 3) % 4]);
+		key(SDL_KEYUP, SDLK_e);
+	}
+	key(SDL_KEYDOWN, Directions[direction]);
+	key(SDL_KEYDOWN, SDLK_e);
+}
+
+//--headless: runs PlayMode for 'frames' frames as fast as possible, with no window or OpenGL context,
+// optionally rendering every frame on the CPU (with PPU466::render_indexed); prints how long it all took.
+//Input comes from the session's replay (which also says how many frames to run, and how long each was) if there is one;
+// otherwise from headless_input(), one Mode::Timestep per frame.
+static int run_headless(uint32_t frames, bool render, FixedSteps &steps, Session &session) {
+	auto before_load = std::chrono::high_resolution_clock::now();
+	call_load_functions_without_gl();
+	auto play = std::make_shared< PlayMode >();
+	Mode::set_current(play);
+	session.play = play;
+	auto before_run = std::chrono::high_resolution_clock::now();
+
+	if (session.replay) frames = uint32_t(session.replay->elapsed.size());
+
+	std::vector< SDL_Event > events;
+	std::vector< uint8_t > pixels;
+	std::vector< glm::u8vec4 > palette;
+	double render_ms = 0.0;
+	uint32_t updates = 0;
+	for (; session.frame < frames && Mode::current; ++session.frame) {
+		events.clear();
+		if (session.replay) session.replay->events(session.frame, &events);
+		else headless_input(session.frame, &events);
+		for (SDL_Event const &evt : events) {
+			if (!Session::replayable(evt)) continue;
+			session.recording.record(evt);
+			play->handle_event(evt, glm::uvec2(PPU466::ScreenWidth, PPU466::ScreenHeight));
+		}
+
+		float elapsed = (session.replay ? session.replay->elapsed[session.frame] : Mode::Timestep);
+		session.recording.elapsed.emplace_back(elapsed);
+		updates += steps.advance(elapsed);
+
+		if (render) {
+			auto before_render = std::chrono::high_resolution_clock::now();
+			play->update_ppu();
+			play->ppu.render_indexed(&pixels, &palette);
+			render_ms += std::chrono::duration< double, std::milli >(std::chrono::high_resolution_clock::now() - before_render).count();
+		}
+	}
+
+	auto after_run = std::chrono::high_resolution_clock::now();
+	double load_ms = std::chrono::duration< double, std::milli >(before_run - before_load).count();
+	double run_ms = std::chrono::duration< double, std::milli >(after_run - before_run).count();
+	std::cout << "Headless: loaded in " << load_ms << " ms; ran " << session.frame << " frames (" << updates << " updates) in " << run_ms << " ms"
+	          << " (" << (run_ms > 0.0 ? session.frame / (run_ms / 1000.0) : 0.0) << " frames/s";
+	if (render) std::cout << ", " << (session.frame ? render_ms / session.frame : 0.0) << " ms/frame of that rendering on the CPU";
+	std::cout << ")." << std::endl;
+
+	session.finish();
+	Mode::set_current(nullptr);
+	return 0;
+}
 
 #ifdef _WIN32
 extern "C" { uint32_t GetACP(); }
@@ -42,10 +310,85 @@ int main(int argc, char **argv) {
 	try {
 #endif
 
+	//------------  command line ------------
+
+	FixedSteps steps;
+	Session session;
+
+	//--headless runs the simulation without a window (see run_headless, above):
+	bool headless = false;
+	uint32_t headless_frames = 10 * 120;
+	bool headless_render = false;
+
+	//--late-latch starts each frame just before the display needs it (see frame_pacing.hpp):
+	bool late_latch = false;
+
+	//--pipelined updates the game on a separate thread from drawing (see SimulationThread, above):
+	bool pipelined = false;
+
+	//--render-on-change skips drawing (and swapping) frames that would look the same as the one already shown,
+	// and waits for input instead -- so an idle game uses next to no CPU or GPU time:
+	bool render_on_change = false;
+	//(while idle, the game still wakes up this often, in case something changes on its own -- e.g., an asset is reloaded)
+	constexpr int32_t IdleWakeMs = 100;
+
+	//reads a whole-number argument (returns false if it isn't one, so the usage message is shown instead):
+	auto parse_count = [](std::string const &str, int32_t *count) -> bool {
+		try {
+			size_t used = 0;
+			*count = std::stoi(str, &used);
+			return used == str.size();
+		} catch (std::exception const &) { //(std::invalid_argument or std::out_of_range)
+			return false;
+		}
+	};
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		int32_t count = 0;
+		if (arg == "--max-catch-up-steps" && i + 1 < argc && parse_count(argv[i+1], &count)) {
+			steps.max_catch_up_steps = uint32_t(std::max(1, count));
+			i += 1;
+		} else if (arg == "--record" && i + 1 < argc) {
+			session.record_to = argv[i+1];
+			i += 1;
+		} else if (arg == "--replay" && i + 1 < argc) {
+			session.replay.reset(new InputRecording(InputRecording::load(argv[i+1])));
+			i += 1;
+		} else if (arg == "--late-latch") {
+			late_latch = true;
+		} else if (arg == "--pipelined") {
+			pipelined = true;
+		} else if (arg == "--render-on-change") {
+			render_on_change = true;
+		} else if (arg == "--headless") {
+			headless = true;
+		} else if (arg == "--frames" && i + 1 < argc && parse_count(argv[i+1], &count)) {
+			headless_frames = uint32_t(std::max(0, count));
+			i += 1;
+		} else if (arg == "--render") {
+			headless_render = true;
+		} else {
+			std::cerr << "Usage:\n"
+			          << "\t" << argv[0] << " [--max-catch-up-steps N] [--late-latch] [--pipelined] [--render-on-change] [--record FILE | --replay FILE]\n"
+			          << "\t" << argv[0] << " --headless [--frames N] [--render] [--record FILE | --replay FILE]" << std::endl;
+			return 1;
+		}
+	}
+
+	if (headless) return run_headless(headless_frames, headless_render, steps, session);
+
 	//------------  initialization ------------
 
+	//time from here to the first frame being shown, and to the first frame after loading:
+	// (see startup_timing.hpp; the report is printed once loading is done)
+	StartupPhase first_frame_timing("main() to first frame");
+	StartupPhase loaded_frame_timing("main() to first frame after loading");
+
 	//Initialize SDL library:
+	StartupPhase sdl_init_timing("SDL_Init");
 	SDL_Init(SDL_INIT_VIDEO);
+	sdl_init_timing.finish();
 
 	//Ask for an OpenGL context version 3.3, core profile, enable debug:
 	SDL_GL_ResetAttributes();
@@ -62,6 +405,7 @@ int main(int argc, char **argv) {
 	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
 
 	//create window:
+	StartupPhase window_timing("SDL_CreateWindow");
 	SDL_Window *window = SDL_CreateWindow(
 		"gp23 game1: The A-Maze-ing Bee",
 		SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
@@ -73,6 +417,7 @@ int main(int argc, char **argv) {
 
 	//prevent exceedingly tiny windows when resizing:
 	SDL_SetWindowMinimumSize(window, PPU466::ScreenWidth, PPU466::ScreenHeight);
+	window_timing.finish();
 
 	if (!window) {
 		std::cerr << "Error creating SDL window: " << SDL_GetError() << std::endl;
@@ -80,7 +425,9 @@ int main(int argc, char **argv) {
 	}
 
 	//Create OpenGL context:
+	StartupPhase context_timing("SDL_GL_CreateContext");
 	SDL_GLContext context = SDL_GL_CreateContext(window);
+	context_timing.finish();
 
 	if (!context) {
 		SDL_DestroyWindow(window);
@@ -102,11 +449,31 @@ int main(int argc, char **argv) {
 	//Hide mouse cursor (note: showing can be useful for debugging):
 	SDL_ShowCursor(SDL_DISABLE);
 
-	//------------ load assets --------------
-	call_load_functions();
+	//With --late-latch, sleep until just before each vblank, and only then poll input, update, and draw:
+	std::unique_ptr< FramePacer > pacer;
+	if (late_latch) {
+		SDL_DisplayMode display_mode;
+		float refresh_rate = 0.0f;
+		if (SDL_GetCurrentDisplayMode(SDL_GetWindowDisplayIndex(window), &display_mode) == 0) {
+			refresh_rate = float(display_mode.refresh_rate);
+		}
+		pacer.reset(new FramePacer(refresh_rate));
+	}
 
-	//------------ create game mode + make current --------------
-	Mode::set_current(std::make_shared< PlayMode >());
+	//Time from each key event to the end of the swap that first shows it (printed at exit):
+	LatencyHistogram input_latency;
+	struct PendingInput {
+		Uint32 timestamp; //of the key event
+		uint64_t frame; //with --pipelined, the posted frame that handles it (see SimulationThread::Snapshot::frames); otherwise 0
+	};
+	std::vector< PendingInput > unpresented_input; //key events whose effects haven't been shown yet
+
+	//------------ load assets + create game mode --------------
+	//assets load in the background while LoadingMode keeps drawing frames; it switches to PlayMode once they're done:
+	Mode::set_current(std::make_shared< LoadingMode >(start_load_functions(), [](){
+		StartupPhase timing("PlayMode construction");
+		return std::make_shared< PlayMode >();
+	}));
 
     //------------ main loop ------------
 
@@ -125,11 +492,44 @@ int main(int argc, char **argv) {
 	};
 	on_resize();
 
+	//With --pipelined, modes that support it are updated on a simulation thread while the main thread draws:
+	std::unique_ptr< SimulationThread > simulation;
+	std::vector< SDL_Event > simulation_events; //events for the simulation thread to handle this frame
+
+	//events go to the current mode (or, if it's on the simulation thread, are passed along there):
+	auto handle_event = [&](SDL_Event const &evt) -> bool {
+		if (simulation) {
+			simulation_events.emplace_back(evt);
+			return false; //(the mode handles it later, so can't say whether it did)
+		}
+		return Mode::current && Mode::current->handle_event(evt, window_size);
+	};
+
+	//With --render-on-change, what's on screen (see PPU466::fingerprint) -- or whether it must be drawn regardless:
+	uint64_t shown_fingerprint = 0;
+	bool must_draw = true; //(e.g., the window was resized or uncovered)
+
 	//This will loop until the current mode is set to null:
-	while (Mode::current) {
+	// (while the simulation thread is running, only it looks at Mode::current)
+	while (simulation || Mode::current) {
 		//every pass through the game loop creates one frame of output
 		//  by performing three steps:
 
+		//(when late latching, wait until the last moment to start the frame)
+		if (pacer) pacer->wait();
+
+		//recording or replaying input starts with the first frame of PlayMode:
+		if (session.wanted() && !session.play) {
+			session.play = std::dynamic_pointer_cast< PlayMode >(Mode::current);
+			if (session.play) steps.unsimulated = 0.0f; //(so stepping starts the same way it did when recording)
+		}
+		bool replaying = session.play && session.replay;
+
+		if (pipelined && !simulation) {
+			PPU466 first;
+			if (Mode::current->snapshot(&first)) simulation.reset(new SimulationThread(steps, first));
+		}
+
 		{ //(1) process any events that are pending
 			static SDL_Event evt;
 			while (SDL_PollEvent(&evt) == 1) {
@@ -137,16 +537,25 @@ int main(int argc, char **argv) {
 				if (evt.type == SDL_WINDOWEVENT && evt.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
 					on_resize();
 				}
+				if (evt.type == SDL_WINDOWEVENT) must_draw = true;
+				//(while replaying, keyboard input comes from the recording instead)
+				if (replaying && (evt.type == SDL_KEYDOWN || evt.type == SDL_KEYUP)) continue;
+				if (session.play && Session::replayable(evt)) session.recording.record(evt);
+				if (evt.type == SDL_KEYDOWN || evt.type == SDL_KEYUP) {
+					//(when pipelined, the event is handled along with the frame posted at the end of this one)
+					unpresented_input.emplace_back(PendingInput{ evt.key.timestamp, simulation ? simulation->posted_frames + 1 : 0 });
+				}
 				//handle input:
-				if (Mode::current && Mode::current->handle_event(evt, window_size)) {
+				if (handle_event(evt)) {
 					// mode handled it; great
 				} else if (evt.type == SDL_QUIT) {
+					simulation.reset();
 					Mode::set_current(nullptr);
 					break;
 				} else if (evt.type == SDL_KEYDOWN && evt.key.keysym.sym == SDLK_PRINTSCREEN) {
 					// --- screenshot key ---
 					std::string filename = "screenshot.png";
-					std::cout << "Saving screenshot to '" << filename << "'." << std::endl;
+					LOG_INFO("Saving screenshot to '{}'.", filename);
 					glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
 					glReadBuffer(GL_FRONT);
 					int w,h;
@@ -159,35 +568,141 @@ int main(int argc, char **argv) {
 					save_png(filename, glm::uvec2(w,h), data.data(), LowerLeftOrigin);
 				}
 			}
-			if (!Mode::current) break;
+			if (!simulation && !Mode::current) break;
+
+			if (replaying) {
+				static std::vector< SDL_Event > replayed;
+				replayed.clear();
+				session.replay->events(session.frame, &replayed);
+				for (SDL_Event const &replayed_evt : replayed) {
+					if (!Session::replayable(replayed_evt)) continue;
+					session.recording.record(replayed_evt);
+					handle_event(replayed_evt);
+				}
+			}
 		}
 
-		{ //(2) call the current mode's "update" function to deal with elapsed time:
+		bool simulation_settled = false; //(with --pipelined: had the simulation thread finished everything, and is there no new input?)
+		{ //(2) call the current mode's "update" function once for every fixed step of elapsed time:
 			auto current_time = std::chrono::high_resolution_clock::now();
 			static auto previous_time = current_time;
 			float elapsed = std::chrono::duration< float >(current_time - previous_time).count();
 			previous_time = current_time;
 
-			//if frames are taking a very long time to process,
-			//lag to avoid spiral of death:
-			elapsed = std::min(0.1f, elapsed);
+			if (replaying) {
+				//the replay is over once it runs out of frames:
+				if (session.frame == session.replay->elapsed.size()) {
+					simulation.reset();
+					Mode::set_current(nullptr);
+					break;
+				}
+				elapsed = session.replay->elapsed[session.frame];
+			}
+			if (session.play) {
+				session.recording.elapsed.emplace_back(elapsed);
+				session.frame += 1;
+			}
 
-			Mode::current->update(elapsed);
-			if (!Mode::current) break;
+			if (simulation) {
+				simulation_settled = simulation->caught_up() && simulation_events.empty();
+				simulation->post(simulation_events, elapsed, window_size);
+				simulation_events.clear();
+			} else {
+				steps.advance(elapsed);
+				if (!Mode::current) break;
+			}
 		}
 
-		{ //(3) call the current mode's "draw" function to produce output:
-		
-			Mode::current->draw(drawable_size);
+		//With --pipelined, pick up the newest frame the simulation thread has finished -- generally, the one before the frame just posted:
+		// (once per pass, so the frame checked for changes below is the same one that gets drawn)
+		if (simulation) simulation->frames.acquire();
+
+		//With --render-on-change, check whether this frame would look any different than the one already shown:
+		// (never skips while replaying, so replays run at full speed)
+		// (without --pipelined, the snapshot taken to check is then drawn as-is, so the mode only builds one frame per pass)
+		bool draw_frame = true;
+		static PPU466 snapshot;
+		bool snapshot_taken = false;
+		if (render_on_change && !replaying) {
+			bool known = false;
+			uint64_t fingerprint = 0;
+			if (simulation) {
+				//(the frame just posted is probably still being simulated, so go by the one before; but only skip drawing
+				// if nothing was still being worked on then, and there's no new input that could make the next one different)
+				fingerprint = simulation->frames.front().ppu.fingerprint();
+				known = simulation_settled;
+			} else if (Mode::current->snapshot(&snapshot)) {
+				snapshot_taken = true;
+				fingerprint = snapshot.fingerprint();
+				known = true;
+			}
+			draw_frame = !known || must_draw || fingerprint != shown_fingerprint;
+			shown_fingerprint = fingerprint;
+			must_draw = false;
 		}
 
-		//Wait until the recently-drawn frame is shown before doing it all again:
-		SDL_GL_SwapWindow(window);
+		if (draw_frame) {
+			{ //(3) call the current mode's "draw" function to produce output:
+				if (simulation) {
+					simulation->frames.front().ppu.draw(drawable_size);
+				} else if (snapshot_taken) {
+					snapshot.draw(drawable_size);
+				} else {
+					Mode::current->draw(drawable_size);
+				}
+			}
+
+			//Wait until the recently-drawn frame is shown before doing it all again:
+			if (pacer) pacer->submitted();
+			if (!first_frame_timing.finished) {
+				{
+					StartupPhase timing("first SDL_GL_SwapWindow");
+					SDL_GL_SwapWindow(window);
+				}
+				first_frame_timing.finish();
+			} else {
+				SDL_GL_SwapWindow(window);
+			}
+			if (pacer) pacer->presented();
+			if (!unpresented_input.empty()) {
+				//(with --pipelined, the frame just shown may have been simulated before some events were handled;
+				// those wait for a later swap)
+				uint64_t shown = simulation ? simulation->frames.front().frames : ~uint64_t(0);
+				Uint32 presented = SDL_GetTicks();
+				auto still_unpresented = std::remove_if(unpresented_input.begin(), unpresented_input.end(), [&](PendingInput const &input) {
+					if (input.frame > shown) return false;
+					input_latency.add(presented - input.timestamp);
+					return true;
+				});
+				unpresented_input.erase(still_unpresented, unpresented_input.end());
+			}
+		} else {
+			//nothing new to show, so sleep until there is input (or, in case something changes on its own, for a little while):
+			unpresented_input.clear(); //(these events didn't change anything visible, so there's no frame to time them to)
+			SDL_WaitEventTimeout(nullptr, IdleWakeMs);
+		}
+
+		if (!simulation && !loaded_frame_timing.finished && !dynamic_cast< LoadingMode * >(Mode::current.get())) {
+			loaded_frame_timing.finish();
+			report_startup_timing();
+		}
+
+		//once the simulated mode changes (e.g., to quit), go back to updating on this thread:
+		if (simulation && simulation->finished) {
+			std::exception_ptr error = simulation->error;
+			simulation.reset();
+			if (error) std::rethrow_exception(error);
+			//(the next frame is drawn on this thread, from the mode's latest state -- which has handled everything)
+			for (PendingInput &input : unpresented_input) input.frame = 0;
+		}
 	}
 
 
 	//------------  teardown ------------
 
+	session.finish();
+	input_latency.report(std::cout);
+
 	SDL_GL_DeleteContext(context);
 	context = 0;
 
@@ -198,9 +713,11 @@ int main(int argc, char **argv) {
 
 #ifdef _WIN32
 	} catch (std::exception const &e) {
+		log_flush(); //(so messages logged before the error are printed before it)
 		std::cerr << "Unhandled exception:\n" << e.what() << std::endl;
 		return 1;
 	} catch (...) {
+		log_flush();
 		std::cerr << "Unhandled exception (unknown type)." << std::endl;
 		throw;
 	}
@@ -1,9 +1,14 @@
 #pragma once
 
+#include "MappedFile.hpp"
+
 #include <iostream>
 #include <vector>
 #include <stdexcept>
 #include <cassert>
+#include <cstring>
+#include <cstdint>
+#include <type_traits>
 
 //helper function that reads an array of structures preceded by a simple header:
 //Expected format:
@@ -35,7 +40,7 @@ void read_chunk(std::istream &from, std::string const &magic, std::vector< T > *
 	}
 
 	to.resize(header.size / sizeof(T));
-	if (!from.read(reinterpret_cast< char * >(&to[0]), to.size() * sizeof(T))) {
+	if (!from.read(reinterpret_cast< char * >(to.data()), to.size() * sizeof(T))) {
 		throw std::runtime_error("Failed to read chunk data.");
 	}
 }
@@ -63,3 +68,71 @@ void write_chunk(std::string const &magic, std::vector< T > const &from, std::os
 	to.write(reinterpret_cast< const char * >(&header), sizeof(header));
 	to.write(reinterpret_cast< const char * >(from.data()), from.size() * sizeof(T));
 }
+
+
+//read-only array of T that lives inside someone else's storage (e.g., a MappedFile):
+// (only valid as long as that storage is)
+template< typename T >
+struct ChunkView {
+	T const *data() const { return data_; }
+	size_t size() const { return size_; }
+	bool empty() const { return size_ == 0; }
+	T const *begin() const { return data_; }
+	T const *end() const { return data_ + size_; }
+	T const &operator[](size_t i) const { assert(i < size_); return data_[i]; }
+
+	T const *data_ = nullptr;
+	size_t size_ = 0;
+};
+
+//helper function that finds a chunk (in the same format as read_chunk) at *offset_ in a block of memory
+// and returns a view of it in place, without allocating or copying.
+//On return, *offset_ is advanced past the chunk.
+//Throws if the header is bad or if the data isn't suitably aligned for T.
+template< typename T >
+ChunkView< T > view_chunk(uint8_t const *from, size_t from_size, size_t *offset_, std::string const &magic) {
+	static_assert(std::is_trivially_copyable< T >::value, "chunk data is used as raw bytes");
+	assert(magic.size() == 4);
+	assert(offset_);
+	auto &offset = *offset_;
+
+	struct ChunkHeader {
+		char magic[4] = {'\0', '\0', '\0', '\0'};
+		uint32_t size = 0;
+	};
+	static_assert(sizeof(ChunkHeader) == 8, "header is packed");
+
+	ChunkHeader header;
+	if (offset > from_size || from_size - offset < sizeof(header)) {
+		throw std::runtime_error("Failed to read chunk header");
+	}
+	//(header may not be aligned, so copy it out rather than pointing at it)
+	std::memcpy(&header, from + offset, sizeof(header));
+	if (std::memcmp(header.magic, magic.data(), 4) != 0) {
+		throw std::runtime_error("Unexpected magic number in chunk");
+	}
+
+	if (header.size % sizeof(T) != 0) {
+		throw std::runtime_error("Size of chunk not divisible by element size");
+	}
+	if (from_size - offset - sizeof(header) < header.size) {
+		throw std::runtime_error("Failed to read chunk data.");
+	}
+
+	uint8_t const *begin = from + offset + sizeof(header);
+	if (reinterpret_cast< uintptr_t >(begin) % alignof(T) != 0) {
+		throw std::runtime_error("Chunk data is not aligned for element type.");
+	}
+
+	offset += sizeof(header) + header.size;
+
+	ChunkView< T > ret;
+	ret.data_ = reinterpret_cast< T const * >(begin);
+	ret.size_ = header.size / sizeof(T);
+	return ret;
+}
+
+template< typename T >
+ChunkView< T > view_chunk(MappedFile const &from, size_t *offset_, std::string const &magic) {
+	return view_chunk< T >(from.data(), from.size(), offset_, magic);
+}
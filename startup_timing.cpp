@@ -0,0 +1,140 @@
+#include "startup_timing.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <vector>
+
+//count allocations per thread by replacing the global allocation functions:
+// (the count is just a thread_local add, so it's cheap enough to leave on after startup)
+namespace {
+	thread_local uint64_t allocated_bytes = 0;
+
+	void *counted_malloc(std::size_t size) {
+		allocated_bytes += size;
+		return std::malloc(size ? size : 1);
+	}
+}
+
+void *operator new(std::size_t size) {
+	if (void *ptr = counted_malloc(size)) return ptr;
+	throw std::bad_alloc();
+}
+void *operator new[](std::size_t size) {
+	if (void *ptr = counted_malloc(size)) return ptr;
+	throw std::bad_alloc();
+}
+void *operator new(std::size_t size, std::nothrow_t const &) noexcept {
+	return counted_malloc(size);
+}
+void *operator new[](std::size_t size, std::nothrow_t const &) noexcept {
+	return counted_malloc(size);
+}
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::nothrow_t const &) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::nothrow_t const &) noexcept { std::free(ptr); }
+
+uint64_t startup_thread_allocated_bytes() {
+	return allocated_bytes;
+}
+
+namespace {
+	struct Record {
+		std::string label;
+		uint32_t thread; //0 is the first thread to record anything (generally the main thread)
+		double begin_ms;
+		double ms;
+		uint64_t bytes;
+	};
+
+	std::mutex records_mutex;
+	std::vector< Record > records;
+
+	double now_ms() {
+		static auto const start = std::chrono::steady_clock::now();
+		return std::chrono::duration< double, std::milli >(std::chrono::steady_clock::now() - start).count();
+	}
+
+	uint32_t thread_index() {
+		static std::atomic< uint32_t > next_index(0);
+		thread_local uint32_t index = next_index.fetch_add(1);
+		return index;
+	}
+
+	std::string json_string(std::string const &str) {
+		std::string ret = "\"";
+		for (char c : str) {
+			if (c == '"' || c == '\\') ret += '\\';
+			if (uint8_t(c) < 0x20) {
+				char buffer[8];
+				std::snprintf(buffer, sizeof(buffer), "\\u%04x", unsigned(uint8_t(c)));
+				ret += buffer;
+			} else {
+				ret += c;
+			}
+		}
+		return ret + "\"";
+	}
+}
+
+StartupPhase::StartupPhase(std::string const &label_) : label(label_), begin_ms(now_ms()), begin_bytes(allocated_bytes) {
+}
+
+StartupPhase::~StartupPhase() {
+	finish();
+}
+
+void StartupPhase::finish() {
+	if (finished) return;
+	finished = true;
+	Record record{label, thread_index(), begin_ms, now_ms() - begin_ms, allocated_bytes - begin_bytes};
+	std::lock_guard< std::mutex > lock(records_mutex);
+	records.emplace_back(std::move(record));
+}
+
+void report_startup_timing() {
+	std::vector< Record > sorted;
+	{
+		std::lock_guard< std::mutex > lock(records_mutex);
+		sorted = records;
+	}
+	std::stable_sort(sorted.begin(), sorted.end(), [](Record const &a, Record const &b) {
+		return a.ms > b.ms;
+	});
+
+	if (char const *json_path = std::getenv("STARTUP_TIMING_JSON")) {
+		std::ofstream json(json_path, std::ios::binary);
+		json << "[\n";
+		for (size_t i = 0; i < sorted.size(); ++i) {
+			Record const &r = sorted[i];
+			json << "\t{ \"label\":" << json_string(r.label) << ", \"thread\":" << r.thread
+			     << ", \"begin_ms\":" << r.begin_ms << ", \"ms\":" << r.ms << ", \"bytes\":" << r.bytes << " }"
+			     << (i + 1 < sorted.size() ? ",\n" : "\n");
+		}
+		json << "]\n";
+		if (!json) {
+			std::cerr << "Failed to write startup timing to '" << json_path << "'." << std::endl;
+		} else {
+			std::cout << "Wrote startup timing to '" << json_path << "'." << std::endl;
+		}
+		return;
+	}
+
+	std::cout << "Startup timing (slowest first):\n";
+	std::cout << "      ms   start ms  thread   KiB alloc  label\n";
+	for (Record const &r : sorted) {
+		char line[80];
+		std::snprintf(line, sizeof(line), "%8.2f  %9.2f  %6u  %10.1f  ", r.ms, r.begin_ms, unsigned(r.thread), r.bytes / 1024.0);
+		std::cout << line << r.label << '\n';
+	}
+	std::cout.flush();
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+/*
+ * Startup timing: records how long each step of startup takes (and how much it allocates),
+ * so it's easy to see where startup time goes:
+ *
+ * StartupPhase sdl_init("SDL_Init");
+ * SDL_Init(SDL_INIT_VIDEO);
+ * sdl_init.finish();
+ *
+ * Every loading function run by call_load_functions() is recorded too, labelled with where its Load<> was constructed.
+ *
+ * report_startup_timing() prints everything recorded as a table, slowest first;
+ *  or, if the STARTUP_TIMING_JSON environment variable is set, writes it as JSON to the file it names.
+ */
+
+#include <string>
+#include <cstdint>
+
+//times everything between construction and finish() (or destruction, if finish() isn't called):
+// (bytes allocated are counted for the calling thread only)
+struct StartupPhase {
+	explicit StartupPhase(std::string const &label);
+	~StartupPhase();
+	void finish();
+
+	StartupPhase(StartupPhase const &) = delete;
+	StartupPhase &operator=(StartupPhase const &) = delete;
+
+	std::string label;
+	double begin_ms; //relative to the first StartupPhase
+	uint64_t begin_bytes;
+	bool finished = false;
+};
+
+//bytes allocated by the calling thread so far (counted by a replacement global operator new):
+uint64_t startup_thread_allocated_bytes();
+
+//print (or write) the report of everything recorded so far; errors writing the report are printed, not thrown:
+void report_startup_timing();
@@ -0,0 +1,14 @@
+#pragma once
+
+/* Tile table slots assigned by TilePacker (see asset_pipeline.hpp) when baking the tile sheets.
+ * This file is generated by the bake-tiles tool (run by Maekfile.js); edit the sheets or Maekfile.js instead. */
+
+#include <cstdint>
+
+namespace TileSlots {
+    constexpr uint8_t Ground = 0;
+    constexpr uint8_t Maze[9] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+    constexpr uint8_t Player = 10;
+    constexpr uint8_t Light = 11;
+    constexpr uint32_t Count = 12; /* slots used (of 256), from 12 tiles */
+}